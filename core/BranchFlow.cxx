@@ -0,0 +1,81 @@
+#include "BranchFlow.hxx"
+#include <cmath>
+
+using namespace gridworks;
+
+BranchArrays::BranchArrays(Grid &g)
+  : n{g.lines.size() + g.transformers.size()},
+    from(n), to(n),
+    g00(n), b00(n), g01(n), b01(n),
+    g10(n), b10(n), g11(n), b11(n),
+    smax(n)
+{
+  branches.reserve(n);
+  branches.insert(branches.end(), g.lines.begin(), g.lines.end());
+  branches.insert(branches.end(), g.transformers.begin(), g.transformers.end());
+
+  for(size_t k=0; k<n; ++k)
+  {
+    Branch &br = *branches[k];
+    PiModel pi = piModel(br);
+    from[k] = br.b[0]->id;
+    to[k] = br.b[1]->id;
+    g00[k] = pi.y00.real(); b00[k] = pi.y00.imag();
+    g01[k] = pi.y01.real(); b01[k] = pi.y01.imag();
+    g10[k] = pi.y10.real(); b10[k] = pi.y10.imag();
+    g11[k] = pi.y11.real(); b11[k] = pi.y11.imag();
+    smax[k] = br.smax;
+  }
+}
+
+FlowResults::FlowResults(size_t n)
+  : n{n}, p0(n), q0(n), p1(n), q1(n), ploss(n), qloss(n), loading(n) {}
+
+void gridworks::branchFlows(const BranchArrays &br, Glob<complex> v,
+                            FlowResults &out)
+{
+  const double *vd = reinterpret_cast<const double*>(v.data);
+  const int *from = br.from.data, *to = br.to.data;
+  const double *g00 = br.g00.data, *b00 = br.b00.data,
+               *g01 = br.g01.data, *b01 = br.b01.data,
+               *g10 = br.g10.data, *b10 = br.b10.data,
+               *g11 = br.g11.data, *b11 = br.b11.data,
+               *smax = br.smax.data;
+  double *p0 = out.p0.data, *q0 = out.q0.data,
+         *p1 = out.p1.data, *q1 = out.q1.data,
+         *pl = out.ploss.data, *ql = out.qloss.data,
+         *ld = out.loading.data;
+  long n = br.n;
+  double lp{0}, lq{0};
+
+  #pragma omp parallel for simd reduction(+:lp,lq)
+  for(long k=0; k<n; ++k)
+  {
+    double ar = vd[2*from[k]], ai = vd[2*from[k]+1],
+           br_ = vd[2*to[k]], bi = vd[2*to[k]+1];
+
+    //end currents of the two port
+    double i0r = g00[k]*ar - b00[k]*ai + g01[k]*br_ - b01[k]*bi,
+           i0i = g00[k]*ai + b00[k]*ar + g01[k]*bi + b01[k]*br_,
+           i1r = g10[k]*ar - b10[k]*ai + g11[k]*br_ - b11[k]*bi,
+           i1i = g10[k]*ai + b10[k]*ar + g11[k]*bi + b11[k]*br_;
+
+    //S = V conj(I)
+    double sp0 = ar*i0r + ai*i0i, sq0 = ai*i0r - ar*i0i,
+           sp1 = br_*i1r + bi*i1i, sq1 = bi*i1r - br_*i1i;
+
+    p0[k] = sp0; q0[k] = sq0;
+    p1[k] = sp1; q1[k] = sq1;
+    pl[k] = sp0 + sp1;
+    ql[k] = sq0 + sq1;
+    lp += sp0 + sp1;
+    lq += sq0 + sq1;
+
+    double s = std::sqrt(std::fmax(sp0*sp0 + sq0*sq0, sp1*sp1 + sq1*sq1));
+    ld[k] = smax[k] > 0 ? s / smax[k] : 0.0;
+  }
+
+  out.total_loss = {lp, lq};
+  out.violations.clear();
+  for(long k=0; k<n; ++k) { if(ld[k] > 1.0) { out.violations.push_back(k); } }
+}
@@ -0,0 +1,55 @@
+#ifndef GW_BRANCHFLOW
+#define GW_BRANCHFLOW
+
+#include "Grid.hxx"
+
+namespace gridworks {
+
+/*=============================================================================
+ * #BranchArrays is a flat, structure of arrays copy of the two port model of
+ * every #Line and #Transformer of a #Grid, lines first. It is gathered once
+ * so that post processing runs over contiguous memory without touching the
+ * branch objects
+ *===========================================================================*/
+struct BranchArrays {
+  //data ----------------------------------------------------------------------
+  size_t          n{0};             //number of branches
+  Glob<int>       from, to;         //bus index of the b[0] and b[1] ends
+  Glob<double>    g00, b00, g01, b01,
+                  g10, b10, g11, b11; //two port admittance, split
+  Glob<double>    smax;             //thermal limit, zero if unlimited
+  vector<Branch*> branches;         //the branch behind each entry
+
+  //constructors --------------------------------------------------------------
+  explicit BranchArrays(Grid &g);
+};
+
+/*=============================================================================
+ * #FlowResults holds the flows into each branch from both ends, the branch
+ * losses and the thermal limit check for one solution, it is allocated once
+ * and overwritten by every call to $branchFlows
+ *===========================================================================*/
+struct FlowResults {
+  //data ----------------------------------------------------------------------
+  size_t          n{0};
+  Glob<double>    p0, q0,           //flow into the branch at the b[0] end
+                  p1, q1,           //flow into the branch at the b[1] end
+                  ploss, qloss,     //series and shunt losses
+                  loading;          //worst end |S| over smax, zero if
+                                    //unlimited
+  vector<size_t>  violations;       //branches loaded beyond their limit
+  complex         total_loss{0,0};
+
+  //constructors --------------------------------------------------------------
+  explicit FlowResults(size_t n);
+};
+
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * The $branchFlows function computes the flows, losses and loading of every
+ * branch in @br at the bus voltages @v into @out
+ *~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~*/
+void branchFlows(const BranchArrays &br, Glob<complex> v, FlowResults &out);
+
+}
+
+#endif
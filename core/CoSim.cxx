@@ -0,0 +1,94 @@
+#include "CoSim.hxx"
+#include <cmath>
+#include <stdexcept>
+
+using namespace gridworks;
+using std::runtime_error;
+using std::to_string;
+
+CoSimulation::CoSimulation(PowerFlow *pf, ip::Simulator *net,
+    vector<uint32_t> host, uint32_t center)
+  : pf{pf}, net{net}, host{host}, center{center}
+{
+  if(host.size() != pf->G->buses.size()) {
+    throw runtime_error("co-simulation needs a host for every bus");
+  }
+}
+
+void CoSimulation::control(uint32_t bus, double value)
+{
+  net->send(net->now, center, host[bus], control_bytes, bus | Control, value);
+}
+
+void CoSimulation::run(double tend)
+{
+  net->deliver = [this](const ip::Delivery &d) { receive(d); };
+  if(!armed)
+  {
+    armed = true;
+    net->at(net->now, [this]() { advance(); });
+    net->at(net->now, [this]() { sample(); });
+  }
+  net->run(tend);
+}
+
+void CoSimulation::solve()
+{
+  if(!dirty) { return; }
+
+  pf->calc_sCalc();
+  pf->calc_dSch();
+  pf->calc_dS();
+  pf->J.update();
+  int it{0};
+  for(; pf->max_dS() > pf->thresh; ++it)
+  {
+    if(it == max_newton || !std::isfinite(pf->max_dS())) {
+      throw runtime_error("co-simulation power flow diverged at t = " +
+                          to_string(net->now));
+    }
+    pf->step();
+  }
+  dirty = false;
+  ++solves;
+  if(visit) { visit(net->now, pf->state); }
+}
+
+void CoSimulation::advance()
+{
+  if(profile)
+  {
+    profile(net->now, pf->sSch);
+    dirty = true;
+  }
+  solve();
+  net->at(net->now + step, [this]() { advance(); });
+}
+
+void CoSimulation::sample()
+{
+  const complex *v = pf->state.data;
+  for(size_t i=0; i<host.size(); ++i) {
+    net->send(net->now, host[i], center, measurement_bytes, i, std::abs(v[i]));
+  }
+  net->at(net->now + period, [this]() { sample(); });
+}
+
+void CoSimulation::receive(const ip::Delivery &d)
+{
+  if(!(d.tag & Control))
+  {
+    ++measurements;
+    if(controller) { controller(d, *this); }
+    return;
+  }
+
+  ++controls;
+  if(actuate) { actuate(d, *this); }
+  if(!dirty)
+  {
+    //the controls actuated before the solve runs share it
+    dirty = true;
+    net->at(net->now, [this]() { solve(); });
+  }
+}
@@ -0,0 +1,73 @@
+#ifndef GW_COSIM
+#define GW_COSIM
+
+#include "PowerFlow.hxx"
+#include "NetSim.hxx"
+#include <functional>
+
+namespace gridworks {
+
+/*=============================================================================
+ * The #CoSimulation couples a time series power flow with the communication
+ * network of the grid, every bus is served by a host of an ip::%Simulator.
+ * Each %period the bus hosts send a measurement of their voltage magnitude
+ * to the %center host, the %controller sees the measurements as they arrive
+ * and answers with $control messages back to the bus hosts, which %actuate
+ * them on the grid once they arrive.
+ *
+ * The power flow runs on the timeline of the network simulation. The load
+ * %profile is applied every %step and otherwise the flow is solved again
+ * only when a control message has been actuated, simultaneous arrivals
+ * share one solve. Measurements read the last solution, so they see a
+ * control only after it has reached its bus
+ *===========================================================================*/
+struct CoSimulation {
+  //types ---------------------------------------------------------------------
+  //sets the scheduled injections for time t
+  using Profile = std::function<void(double, Glob<complex>)>;
+  using Handler = std::function<void(const ip::Delivery&, CoSimulation&)>;
+  using Visitor = std::function<void(double, Glob<complex>)>;
+
+  //the tag of a message is its bus, control messages also carry this flag
+  enum : uint32_t { Control = 1u << 31 };
+
+  //data ----------------------------------------------------------------------
+  PowerFlow         *pf;
+  ip::Simulator     *net;
+  vector<uint32_t>  host;           //host serving each bus
+  uint32_t          center;         //host of the control centre
+  double            period{1.0},    //measurement period, seconds
+                    step{60.0};     //time series step, seconds
+  uint32_t          measurement_bytes{64}, control_bytes{64};
+  int               max_newton{20};
+
+  Profile           profile;
+  Handler           controller,     //called at the centre per measurement
+                    actuate;        //called at a bus per control
+  Visitor           visit;          //called after every solve
+
+  bool              dirty{true}, armed{false};
+  size_t            solves{0}, measurements{0}, controls{0};
+
+  //constructors --------------------------------------------------------------
+  CoSimulation(PowerFlow *pf, ip::Simulator *net, vector<uint32_t> host,
+      uint32_t center);
+
+  //methods -------------------------------------------------------------------
+  //sends a control of @value for @bus from the centre, now
+  void control(uint32_t bus, double value);
+
+  //runs both simulations up to time @tend
+  void run(double tend);
+
+  //solves the flow if anything changed since the last solve
+  void solve();
+
+  void sample();
+  void advance();
+  void receive(const ip::Delivery &d);
+};
+
+}
+
+#endif
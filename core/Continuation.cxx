@@ -0,0 +1,209 @@
+#include "Continuation.hxx"
+#include <algorithm>
+#include <cmath>
+
+using namespace gridworks;
+using std::vector;
+using std::runtime_error;
+using std::to_string;
+
+ContinuationPowerFlow::ContinuationPowerFlow(Grid *g, Glob<complex> state,
+    Glob<complex> sSch, Glob<complex> dir, double thresh)
+  : pf{g, state, sSch.clone(), thresh}, s0{sSch.clone()}, dir{dir},
+    nose(g->buses.size())
+{
+  const SMatrix<double> &J = *pf.J.m;
+  sindex N = J.n;
+
+  //every row of J gains the load column N, row N is dense
+  A = SMatrix<double>(N+1, J.s + N + N+1);
+  jpos.resize(J.s);
+  sindex e{0};
+  for(sindex i=0; i<N; ++i)
+  {
+    A.r[i] = e;
+    for(sindex k=J.r[i]; k<J.r[i+1]; ++k)
+    {
+      A.c[e] = J.c[k];
+      jpos[k] = e++;
+    }
+    A.c[e++] = N;
+  }
+  A.r[N] = e;
+  for(sindex j=0; j<=N; ++j) { A.c[e++] = j; }
+  A.r[N+1] = e;
+
+  //the direction in the rows of the jacobian
+  d.assign(N, 0);
+  for(size_t i=0; i<g->buses.size(); ++i)
+  {
+    const Bus &b = *g->buses[i];
+    if(b.slack) { continue; }
+    d[b.jidx[0]] = dir.data[i].real();
+    if(b.qRow() && !b.vControlled()) { d[b.jidx[1]] = dir.data[i].imag(); }
+  }
+
+  t.assign(N+1, 0);
+  rhs.assign(N+1, 0);
+  z.assign(N+1, 0);
+
+  mkl_err = dss_create(mkl_handle, dss_opt);
+  if(mkl_err != MKL_DSS_SUCCESS) { mkl_death(); }
+
+  mkl_err = dss_define_structure(
+      mkl_handle, dss_struct_opt, A.r, A.n, A.n, A.c, A.s);
+  if(mkl_err != MKL_DSS_SUCCESS) { mkl_death(); }
+
+  mkl_err = dss_reorder(mkl_handle, dss_reorder_opt, 0);
+  if(mkl_err != MKL_DSS_SUCCESS) { mkl_death(); }
+}
+
+ContinuationPowerFlow::~ContinuationPowerFlow()
+{
+  dss_delete(mkl_handle, dss_solve_opt);
+}
+
+void ContinuationPowerFlow::mkl_death()
+{
+  throw runtime_error{
+    "MKL has exploded with error: " + to_string(mkl_err)
+  };
+}
+
+void ContinuationPowerFlow::setLambda(double l)
+{
+  lambda = l;
+  for(size_t i=0; i<s0.sz; ++i) {
+    pf.sSch.data[i] = s0.data[i] + l * dir.data[i];
+  }
+}
+
+void ContinuationPowerFlow::factor(int k)
+{
+  const SMatrix<double> &J = *pf.J.m;
+  sindex N = J.n;
+  for(sindex i=0; i<J.s; ++i) { A.v[jpos[i]] = J.v[i]; }
+  for(sindex i=0; i<N; ++i) { A.v[A.r[i+1]-1] = -d[i]; }
+  std::fill(A.v + A.r[N], A.v + A.r[N+1], 0.0);
+  A.v[A.r[N] + k] = 1.0;
+
+  mkl_err = dss_factor_real(mkl_handle, dss_factor_opt, A.v);
+  if(mkl_err != MKL_DSS_SUCCESS) { mkl_death(); }
+}
+
+void ContinuationPowerFlow::tangent(int k, double sign)
+{
+  pf.J.update();
+  factor(k);
+
+  //[J -d; e_k] t = [0; sign]
+  std::fill(rhs.begin(), rhs.end(), 0.0);
+  rhs.back() = sign;
+  _INTEGER_t nrhs{1};
+  mkl_err =
+    dss_solve_real(mkl_handle, dss_solve_opt, rhs.data(), nrhs, t.data());
+  if(mkl_err != MKL_DSS_SUCCESS) { mkl_death(); }
+
+  double norm{0};
+  for(double x : t) { norm += x*x; }
+  norm = std::sqrt(norm);
+  for(double &x : t) { x /= norm; }
+}
+
+int ContinuationPowerFlow::correct(int k)
+{
+  sindex N = pf.J.m->n;
+  _INTEGER_t nrhs{1};
+  for(int it=0; it<=max_corrector; ++it)
+  {
+    pf.calc_sCalc();
+    pf.calc_dSch();
+    pf.calc_dS();
+    if(pf.max_dS() < pf.thresh) { return it; }
+    if(it == max_corrector || !std::isfinite(pf.max_dS())) { break; }
+
+    //[J -d; e_k] dz = [dS; 0]
+    pf.J.update();
+    factor(k);
+    std::copy(pf.dS.data, pf.dS.data + N, rhs.begin());
+    rhs.back() = 0;
+    mkl_err =
+      dss_solve_real(mkl_handle, dss_solve_opt, rhs.data(), nrhs, z.data());
+    if(mkl_err != MKL_DSS_SUCCESS) { mkl_death(); }
+
+    std::copy(z.begin(), z.begin() + N, pf.dX.data);
+    pf.update_state();
+    setLambda(lambda + z.back());
+  }
+  return -1;
+}
+
+double ContinuationPowerFlow::run(const Visitor &visit)
+{
+  size_t nb = s0.sz;
+  sindex N = pf.J.m->n;
+
+  setLambda(0);
+  pf.run();
+  lambda_max = 0;
+  points = 0;
+  std::copy(pf.state.data, pf.state.data + nb, nose.data);
+  if(visit) { visit(lambda, pf.state); }
+
+  //start by increasing lambda
+  int k = N;
+  double sign{1};
+  tangent(k, sign);
+
+  vector<complex> saved(nb);
+  vector<double> prev(N+1);
+  while(points < max_points)
+  {
+    std::copy(pf.state.data, pf.state.data + nb, saved.begin());
+    double l0 = lambda;
+
+    //predictor
+    std::copy(t.begin(), t.begin() + N, pf.dX.data);
+    for(sindex i=0; i<N; ++i) { pf.dX.data[i] *= step; }
+    pf.update_state();
+    setLambda(l0 + step * t[N]);
+
+    int its = correct(k);
+    if(its < 0)
+    {
+      std::copy(saved.begin(), saved.end(), pf.state.data);
+      setLambda(l0);
+      step *= 0.5;
+      if(step < min_step) { break; }
+      continue;
+    }
+
+    ++points;
+    if(visit) { visit(lambda, pf.state); }
+    if(lambda > lambda_max)
+    {
+      lambda_max = lambda;
+      std::copy(pf.state.data, pf.state.data + nb, nose.data);
+    }
+
+    //continue along the unknown changing fastest
+    prev = t;
+    k = 0;
+    for(sindex i=1; i<=N; ++i) {
+      if(std::abs(t[i]) > std::abs(t[k])) { k = i; }
+    }
+    sign = t[k] < 0 ? -1.0 : 1.0;
+    tangent(k, sign);
+
+    //curvature from the turn of the tangent
+    double cos{0};
+    for(sindex i=0; i<=N; ++i) { cos += t[i] * prev[i]; }
+    if(its <= 3 && cos > 0.99) { step = std::min(step * 1.5, max_step); }
+    else if(its > 5 || cos < 0.9) { step = std::max(step * 0.5, min_step); }
+
+    if(lambda < 0) { break; }
+    if(t[N] < 0 && lambda < stop_fraction * lambda_max) { break; }
+  }
+
+  return lambda_max;
+}
@@ -0,0 +1,90 @@
+#ifndef GW_CONTINUATION
+#define GW_CONTINUATION
+
+#include "PowerFlow.hxx"
+#include <functional>
+
+namespace gridworks {
+
+/*=============================================================================
+ * The #ContinuationPowerFlow traces the P-V curve of a grid as the schedule
+ * moves along a transfer direction, sSch(lambda) = sSch + lambda dir, and
+ * finds the loadability margin lambda_max at the nose of the curve.
+ *
+ * Each point is a tangent predictor followed by a Newton corrector on the
+ * jacobian of %pf augmented with the load column -dir and one parameter row
+ * e_k that fixes the unknown changing fastest along the curve, so the nose
+ * is passed without the jacobian becoming singular. The augmented matrix
+ * keeps one pattern for the whole trace, the last column and row are stored
+ * dense, and the symbolic analysis is done once. The step grows while the
+ * corrector converges quickly on a straight part of the curve and shrinks
+ * where the tangent turns. Bus kinds are held as they are when the trace
+ * starts, reactive limits are not switched along the curve
+ *===========================================================================*/
+struct ContinuationPowerFlow {
+  //types ---------------------------------------------------------------------
+  //receives lambda and the bus voltages of every point on the curve
+  using Visitor = std::function<void(double, Glob<complex>)>;
+
+  //data ----------------------------------------------------------------------
+  PowerFlow         pf;             //solver at the current point
+  Glob<complex>     s0, dir;        //base schedule and transfer direction
+  Glob<complex>     nose;           //bus voltages at lambda_max
+  SMatrix<double>   A{0,0};         //augmented jacobian
+  vector<sindex>    jpos;           //slot in A of every entry of pf.J
+  vector<double>    d, t, rhs, z;   //reduced direction, unit tangent
+
+  double            lambda{0}, lambda_max{0},
+                    step{0.1},      //predictor step along the tangent
+                    min_step{1e-4}, max_step{1.0},
+                    stop_fraction{0.9}; //stop once back down to this
+                                        //fraction of lambda_max
+  int               max_points{500}, max_corrector{10}, points{0};
+
+  _MKL_DSS_HANDLE_t mkl_handle;
+  _INTEGER_t mkl_err{ MKL_DSS_SUCCESS };
+  _INTEGER_t
+    dss_opt{ MKL_DSS_MSG_LVL_WARNING +
+             MKL_DSS_TERM_LVL_ERROR +
+             MKL_DSS_ZERO_BASED_INDEXING
+           },
+    dss_struct_opt{ MKL_DSS_NON_SYMMETRIC },
+    dss_reorder_opt{ MKL_DSS_AUTO_ORDER },
+    dss_factor_opt{ MKL_DSS_INDEFINITE },
+    dss_solve_opt{ MKL_DSS_DEFAULTS };
+
+  //constructors --------------------------------------------------------------
+  //@state is the starting guess and is updated along the curve like the
+  //state of a #PowerFlow, @sSch is copied
+  ContinuationPowerFlow(Grid *g, Glob<complex> state, Glob<complex> sSch,
+                        Glob<complex> dir, double thresh = 1e-8);
+  ~ContinuationPowerFlow();
+  ContinuationPowerFlow(const ContinuationPowerFlow &) = delete;
+  ContinuationPowerFlow & operator=(const ContinuationPowerFlow &) = delete;
+
+  //methods -------------------------------------------------------------------
+  //solves the base case then traces the curve past the nose, handing every
+  //point to @visit, returns lambda_max
+  double run(const Visitor &visit = nullptr);
+
+  //moves the schedule of pf to @l
+  void setLambda(double l);
+
+  //loads the augmented matrix with the current jacobian and the parameter
+  //row e_@k, and factors it
+  void factor(int k);
+
+  //unit tangent at the current point, oriented so that its @k entry has the
+  //sign @sign
+  void tangent(int k, double sign);
+
+  //Newton corrector with unknown @k held, returns the iterations used or -1
+  //if it did not converge
+  int correct(int k);
+
+  void mkl_death();
+};
+
+}
+
+#endif
@@ -0,0 +1,479 @@
+#include "DcOpf.hxx"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace gridworks;
+using std::runtime_error;
+using std::to_string;
+
+//the longest step along @dv that keeps @v nonnegative
+static double maxStep(const vector<double> &v, const vector<double> &dv)
+{
+  double a = std::numeric_limits<double>::infinity();
+  for(size_t i=0; i<v.size(); ++i) {
+    if(dv[i] < 0) { a = std::min(a, -v[i] / dv[i]); }
+  }
+  return a;
+}
+
+static double maxAbs(const vector<double> &v)
+{
+  double m{0};
+  for(double a : v) { m = std::max(m, std::abs(a)); }
+  return m;
+}
+
+DcOpf::DcOpf(Grid *g) : G{g}
+{
+  build();
+}
+
+DcOpf::~DcOpf()
+{
+  if(analyzed) { dss_delete(mkl_handle, dss_solve_opt); }
+}
+
+void DcOpf::mkl_death()
+{
+  throw runtime_error{
+    "MKL has exploded with error: " + to_string(mkl_err)
+  };
+}
+
+vector<int> DcOpf::limits() const
+{
+  vector<int> l{int(G->buses.size()), int(G->generators.size()),
+                int(G->lines.size() + G->transformers.size())};
+  for(const Bus *b : G->buses) { l.push_back(b->slack); }
+  for(const Generator *g : G->generators)
+  {
+    l.push_back(g->bus ? g->bus->id : -1);
+    l.push_back(std::isfinite(g->pmin));
+    l.push_back(std::isfinite(g->pmax));
+  }
+  auto branch = [&l](const Branch *br)
+  {
+    l.push_back(br->b[0]->id);
+    l.push_back(br->b[1]->id);
+    l.push_back(br->smax > 0);
+  };
+  for(const Line *br : G->lines) { branch(br); }
+  for(const Transformer *br : G->transformers) { branch(br); }
+  return l;
+}
+
+void DcOpf::build()
+{
+  size_t nb = G->buses.size(),
+         ng = G->generators.size();
+
+  branches.clear();
+  branches.insert(branches.end(), G->lines.begin(), G->lines.end());
+  branches.insert(branches.end(),
+                  G->transformers.begin(), G->transformers.end());
+
+  //variables: angles of the non slack buses then the generator outputs
+  nt = 0;
+  ti.assign(nb, -1);
+  for(size_t i=0; i<nb; ++i) { if(!G->buses[i]->slack) { ti[i] = nt++; } }
+  nx = nt + ng;
+  for(size_t g=0; g<ng; ++g) {
+    if(!G->generators[g]->bus) {
+      throw runtime_error("generator " + to_string(G->generators[g]->id) +
+          " is not attached to a bus");
+    }
+  }
+
+  //balance of each bus over its own and its neighbors angles and its
+  //generators
+  vector<vector<sindex>> arows(nb);
+  for(const Branch *br : branches)
+  {
+    int a = br->b[0]->id, b = br->b[1]->id;
+    for(int i : {a, b}) {
+      for(int j : {a, b}) { if(ti[j] >= 0) { arows[i].push_back(ti[j]); } }
+    }
+  }
+  for(size_t g=0; g<ng; ++g) {
+    arows[G->generators[g]->bus->id].push_back(nt + g);
+  }
+  vector<sindex> arow{0}, acol;
+  for(vector<sindex> &ar : arows)
+  {
+    std::sort(ar.begin(), ar.end());
+    ar.erase(std::unique(ar.begin(), ar.end()), ar.end());
+    acol.insert(acol.end(), ar.begin(), ar.end());
+    arow.push_back(acol.size());
+  }
+  A = SMatrix<double>(nb, acol.size());
+  std::copy(arow.begin(), arow.end(), A.r);
+  std::copy(acol.begin(), acol.end(), A.c);
+
+  auto aslotOf = [this](int i, sindex col) -> sindex {
+    if(col < 0) { return -1; }
+    return std::lower_bound(A.c + A.r[i], A.c + A.r[i+1], col) - A.c;
+  };
+  bslot.clear();
+  for(const Branch *br : branches)
+  {
+    int a = br->b[0]->id, b = br->b[1]->id;
+    bslot.push_back(aslotOf(a, ti[a]));
+    bslot.push_back(aslotOf(a, ti[b]));
+    bslot.push_back(aslotOf(b, ti[a]));
+    bslot.push_back(aslotOf(b, ti[b]));
+  }
+  pslot.resize(ng);
+  for(size_t g=0; g<ng; ++g) {
+    pslot[g] = aslotOf(G->generators[g]->bus->id, nt + g);
+  }
+
+  //inequalities: upper then lower output bounds of each generator, then
+  //both directions of each limited branch, in the order update() fills them
+  vector<sindex> grow{0}, gcol;
+  for(size_t g=0; g<ng; ++g)
+  {
+    const Generator *gen = G->generators[g];
+    for(bool finite : {std::isfinite(gen->pmax), std::isfinite(gen->pmin)})
+    {
+      if(!finite) { continue; }
+      gcol.push_back(nt + g);
+      grow.push_back(gcol.size());
+    }
+  }
+  for(const Branch *br : branches)
+  {
+    if(!(br->smax > 0)) { continue; }
+    vector<sindex> cols;
+    for(const Bus *b : br->b) {
+      if(ti[b->id] >= 0) { cols.push_back(ti[b->id]); }
+    }
+    std::sort(cols.begin(), cols.end());
+    for(int dir=0; dir<2; ++dir)
+    {
+      gcol.insert(gcol.end(), cols.begin(), cols.end());
+      grow.push_back(gcol.size());
+    }
+  }
+  nc = grow.size() - 1;
+  Gi = SMatrix<double>(nc, gcol.size());
+  std::copy(grow.begin(), grow.end(), Gi.r);
+  std::copy(gcol.begin(), gcol.end(), Gi.c);
+
+  //KKT pattern, upper triangle: the diagonal, the couplings of the
+  //variables sharing an inequality and A' in the upper right block
+  sindex nk = nx + nb;
+  vector<vector<sindex>> krows(nk);
+  for(sindex k=0; k<nk; ++k) { krows[k].push_back(k); }
+  for(sindex r=0; r<nc; ++r) {
+    for(sindex p=Gi.r[r]; p<Gi.r[r+1]; ++p) {
+      for(sindex t=p+1; t<Gi.r[r+1]; ++t) {
+        krows[std::min(Gi.c[p], Gi.c[t])].push_back(
+            std::max(Gi.c[p], Gi.c[t]));
+      }
+    }
+  }
+  for(size_t i=0; i<nb; ++i) {
+    for(sindex k=A.r[i]; k<A.r[i+1]; ++k) {
+      krows[A.c[k]].push_back(nx + i);
+    }
+  }
+  vector<sindex> krow{0}, kcol;
+  for(vector<sindex> &kr : krows)
+  {
+    std::sort(kr.begin(), kr.end());
+    kr.erase(std::unique(kr.begin(), kr.end()), kr.end());
+    kcol.insert(kcol.end(), kr.begin(), kr.end());
+    krow.push_back(kcol.size());
+  }
+  K = SMatrix<double>(nk, kcol.size());
+  std::copy(krow.begin(), krow.end(), K.r);
+  std::copy(kcol.begin(), kcol.end(), K.c);
+
+  auto kslotOf = [this](sindex a, sindex b) -> sindex {
+    return std::lower_bound(K.c + K.r[a], K.c + K.r[a+1], b) - K.c;
+  };
+  kdiag.resize(nk);
+  for(sindex k=0; k<nk; ++k) { kdiag[k] = kslotOf(k, k); }
+  aslot.resize(A.s);
+  for(size_t i=0; i<nb; ++i) {
+    for(sindex k=A.r[i]; k<A.r[i+1]; ++k) {
+      aslot[k] = kslotOf(A.c[k], nx + i);
+    }
+  }
+  gpair.clear();
+  goff.clear();
+  for(sindex r=0; r<nc; ++r)
+  {
+    goff.push_back(gpair.size());
+    for(sindex p=Gi.r[r]; p<Gi.r[r+1]; ++p) {
+      for(sindex t=p; t<Gi.r[r+1]; ++t) {
+        gpair.push_back(p);
+        gpair.push_back(t);
+        gpair.push_back(kslotOf(std::min(Gi.c[p], Gi.c[t]),
+                                std::max(Gi.c[p], Gi.c[t])));
+      }
+    }
+  }
+  goff.push_back(gpair.size());
+
+  if(analyzed)
+  {
+    dss_delete(mkl_handle, dss_solve_opt);
+    analyzed = false;
+  }
+  mkl_err = dss_create(mkl_handle, dss_opt);
+  if(mkl_err != MKL_DSS_SUCCESS) { mkl_death(); }
+  analyzed = true;
+
+  mkl_err = dss_define_structure(
+      mkl_handle, dss_struct_opt, K.r, K.n, K.n, K.c, K.s);
+  if(mkl_err != MKL_DSS_SUCCESS) { mkl_death(); }
+
+  mkl_err = dss_reorder(mkl_handle, dss_reorder_opt, 0);
+  if(mkl_err != MKL_DSS_SUCCESS) { mkl_death(); }
+
+  bb.assign(branches.size(), 0);
+  bal.assign(nb, 0);
+  h.assign(nc, 0);
+  c.assign(nx, 0);
+  q.assign(nx, 0);
+  x.assign(nx, 0);
+  y.assign(nb, 0);
+  s.assign(nc, 0);
+  z.assign(nc, 0);
+  warm = false;
+  shape = limits();
+}
+
+void DcOpf::update(const double *demand)
+{
+  size_t nb = G->buses.size(),
+         ng = G->generators.size();
+
+  A.zero();
+  for(size_t k=0; k<branches.size(); ++k)
+  {
+    double xs = branches[k]->z().imag();
+    if(xs == 0 || !std::isfinite(xs)) {
+      throw runtime_error("branch " + to_string(branches[k]->id) +
+          " has no series reactance for the DC model");
+    }
+    bb[k] = 1.0 / xs;
+    const sindex *sl = &bslot[4*k];
+    double v[4]{bb[k], -bb[k], -bb[k], bb[k]};
+    for(int t=0; t<4; ++t) { if(sl[t] >= 0) { A.v[sl[t]] += v[t]; } }
+  }
+  for(size_t g=0; g<ng; ++g) { A.v[pslot[g]] = -1; }
+  for(size_t i=0; i<nb; ++i) { bal[i] = -demand[i]; }
+
+  for(size_t g=0; g<ng; ++g)
+  {
+    c[nt + g] = G->generators[g]->c1;
+    q[nt + g] = 2 * G->generators[g]->c2;
+  }
+
+  //same walk as build()
+  sindex r{0};
+  for(const Generator *gen : G->generators)
+  {
+    if(std::isfinite(gen->pmax))
+    {
+      Gi.v[Gi.r[r]] = 1;
+      h[r++] = gen->pmax;
+    }
+    if(std::isfinite(gen->pmin))
+    {
+      Gi.v[Gi.r[r]] = -1;
+      h[r++] = -gen->pmin;
+    }
+  }
+  for(size_t k=0; k<branches.size(); ++k)
+  {
+    const Branch *br = branches[k];
+    if(!(br->smax > 0)) { continue; }
+    sindex from = ti[br->b[0]->id];
+    for(double dir : {1.0, -1.0})
+    {
+      for(sindex p=Gi.r[r]; p<Gi.r[r+1]; ++p) {
+        Gi.v[p] = dir * (Gi.c[p] == from ? bb[k] : -bb[k]);
+      }
+      h[r++] = br->smax;
+    }
+  }
+}
+
+void DcOpf::factor()
+{
+  K.zero();
+  for(sindex k=0; k<nx; ++k) { K.v[kdiag[k]] = q[k] + reg; }
+  for(sindex k=nx; k<K.n; ++k) { K.v[kdiag[k]] = -reg; }
+  for(sindex k=0; k<A.s; ++k) { K.v[aslot[k]] = A.v[k]; }
+  for(sindex r=0; r<nc; ++r)
+  {
+    double d = z[r] / s[r];
+    for(sindex k=goff[r]; k<goff[r+1]; k+=3) {
+      K.v[gpair[k+2]] += d * Gi.v[gpair[k]] * Gi.v[gpair[k+1]];
+    }
+  }
+
+  mkl_err = dss_factor_real(mkl_handle, dss_factor_opt, K.v);
+  if(mkl_err != MKL_DSS_SUCCESS) {
+    throw runtime_error("DC OPF KKT system is singular, check that every "
+        "island has a slack bus and a generator");
+  }
+}
+
+void DcOpf::kktSolve(vector<double> &r)
+{
+  vector<double> sol(r.size());
+  _INTEGER_t nrhs{1};
+  mkl_err =
+    dss_solve_real(mkl_handle, dss_solve_opt, r.data(), nrhs, sol.data());
+  if(mkl_err != MKL_DSS_SUCCESS) { mkl_death(); }
+  r.swap(sol);
+}
+
+bool DcOpf::solve(const double *demand)
+{
+  if(shape != limits()) { build(); }
+  update(demand);
+
+  size_t nb = G->buses.size(),
+         ng = G->generators.size();
+  double m = nc;
+
+  vector<double> gx(nc), rp(nb), rd(nx), rg(nc), rc(nc),
+                 dx(nx), dy(nb), ds(nc), dz(nc), kr(nx + nb);
+
+  auto product = [this](const vector<double> &v, vector<double> &gv) {
+    std::fill(gv.begin(), gv.end(), 0.0);
+    for(sindex r=0; r<nc; ++r) {
+      for(sindex p=Gi.r[r]; p<Gi.r[r+1]; ++p) { gv[r] += Gi.v[p]*v[Gi.c[p]]; }
+    }
+  };
+
+  //starting point, the last solution with its slacks and multipliers moved
+  //into the interior, or the middle of the output bounds
+  if(!warm)
+  {
+    std::fill(x.begin(), x.end(), 0.0);
+    for(size_t g=0; g<ng; ++g)
+    {
+      const Generator *gen = G->generators[g];
+      bool lo = std::isfinite(gen->pmin), hi = std::isfinite(gen->pmax);
+      x[nt + g] = lo && hi ? (gen->pmin + gen->pmax) / 2 :
+                  lo ? gen->pmin + 1 : hi ? gen->pmax - 1 : 0;
+    }
+    std::fill(y.begin(), y.end(), 0.0);
+    std::fill(z.begin(), z.end(), 1.0);
+  }
+  product(x, gx);
+  double inner = warm ? warm_shift : 1.0;
+  for(sindex r=0; r<nc; ++r)
+  {
+    s[r] = std::max(h[r] - gx[r], inner);
+    z[r] = std::max(z[r], inner);
+  }
+
+  //the newton direction for the complementarity residual @rc
+  auto direction = [&]()
+  {
+    for(sindex r=0; r<nc; ++r) { ds[r] = (rc[r] - z[r] * rg[r]) / s[r]; }
+    std::fill(kr.begin(), kr.end(), 0.0);
+    for(sindex k=0; k<nx; ++k) { kr[k] = -rd[k]; }
+    for(sindex r=0; r<nc; ++r) {
+      for(sindex p=Gi.r[r]; p<Gi.r[r+1]; ++p) { kr[Gi.c[p]] += Gi.v[p]*ds[r]; }
+    }
+    for(size_t i=0; i<nb; ++i) { kr[nx + i] = -rp[i]; }
+    kktSolve(kr);
+    std::copy(kr.begin(), kr.begin() + nx, dx.begin());
+    for(size_t i=0; i<nb; ++i) { dy[i] = -kr[nx + i]; }
+    product(dx, ds);
+    for(sindex r=0; r<nc; ++r)
+    {
+      ds[r] = -rg[r] - ds[r];
+      dz[r] = (-rc[r] - z[r] * ds[r]) / s[r];
+    }
+  };
+
+  double pscale = 1 + std::max(maxAbs(bal), maxAbs(h)),
+         dscale = 1 + std::max(maxAbs(c), maxAbs(q));
+  bool converged{false};
+  for(iterations=0; ; ++iterations)
+  {
+    //residuals of the balances, the inequalities and the stationarity
+    for(size_t i=0; i<nb; ++i) { rp[i] = -bal[i]; }
+    for(size_t i=0; i<nb; ++i) {
+      for(sindex k=A.r[i]; k<A.r[i+1]; ++k) { rp[i] += A.v[k] * x[A.c[k]]; }
+    }
+    product(x, gx);
+    for(sindex r=0; r<nc; ++r) { rg[r] = gx[r] + s[r] - h[r]; }
+    for(sindex k=0; k<nx; ++k) { rd[k] = q[k] * x[k] + c[k]; }
+    for(size_t i=0; i<nb; ++i) {
+      for(sindex k=A.r[i]; k<A.r[i+1]; ++k) { rd[A.c[k]] -= A.v[k] * y[i]; }
+    }
+    for(sindex r=0; r<nc; ++r) {
+      for(sindex p=Gi.r[r]; p<Gi.r[r+1]; ++p) { rd[Gi.c[p]] += Gi.v[p]*z[r]; }
+    }
+    double mu{0};
+    for(sindex r=0; r<nc; ++r) { mu += s[r] * z[r]; }
+    mu = nc ? mu / m : 0.0;
+
+    double pres = std::max(maxAbs(rp), maxAbs(rg)),
+           dres = maxAbs(rd);
+    if(pres <= tol * pscale && dres <= tol * dscale && mu <= tol * dscale)
+    {
+      converged = true;
+      break;
+    }
+    if(iterations == max_iter || !std::isfinite(pres + dres + mu)) { break; }
+
+    factor();
+
+    //predictor, the affine scaling direction
+    for(sindex r=0; r<nc; ++r) { rc[r] = s[r] * z[r]; }
+    direction();
+    double a = std::min({1.0, maxStep(s, ds), maxStep(z, dz)}),
+           mu_aff{0};
+    for(sindex r=0; r<nc; ++r) {
+      mu_aff += (s[r] + a*ds[r]) * (z[r] + a*dz[r]);
+    }
+    mu_aff = nc ? mu_aff / m : 0.0;
+    double sigma = mu > 0 ? std::pow(mu_aff / mu, 3) : 0.0;
+
+    //corrector, centered and with the second order term of the predictor
+    for(sindex r=0; r<nc; ++r) {
+      rc[r] = s[r] * z[r] + ds[r] * dz[r] - sigma * mu;
+    }
+    direction();
+    a = std::min({1.0, step_fraction * maxStep(s, ds),
+                       step_fraction * maxStep(z, dz)});
+    for(sindex k=0; k<nx; ++k) { x[k] += a * dx[k]; }
+    for(size_t i=0; i<nb; ++i) { y[i] += a * dy[i]; }
+    for(sindex r=0; r<nc; ++r)
+    {
+      s[r] += a * ds[r];
+      z[r] += a * dz[r];
+    }
+  }
+  warm = converged;
+
+  theta.assign(nb, 0);
+  for(size_t i=0; i<nb; ++i) { if(ti[i] >= 0) { theta[i] = x[ti[i]]; } }
+  pg.assign(x.begin() + nt, x.end());
+  flow.resize(branches.size());
+  for(size_t k=0; k<branches.size(); ++k) {
+    flow[k] = bb[k] * (theta[branches[k]->b[0]->id] -
+                       theta[branches[k]->b[1]->id]);
+  }
+  lmp.resize(nb);
+  for(size_t i=0; i<nb; ++i) { lmp[i] = -y[i]; }
+  cost = 0;
+  for(size_t g=0; g<ng; ++g)
+  {
+    const Generator *gen = G->generators[g];
+    cost += gen->c0 + gen->c1 * pg[g] + gen->c2 * pg[g] * pg[g];
+  }
+  return converged;
+}
@@ -0,0 +1,121 @@
+#ifndef GW_DCOPF
+#define GW_DCOPF
+
+#include "Grid.hxx"
+#include <mkl_dss.h>
+#include <stdexcept>
+#include <string>
+
+namespace gridworks {
+
+/*=============================================================================
+ * The #DcOpf dispatches the generators of a grid at least cost under the DC
+ * power flow model, with Generator::pmin and Generator::pmax bounding each
+ * output and Branch::smax bounding the flow of each branch in both
+ * directions. The cost of a generator is c0 + c1 P + c2 P^2. Branches carry
+ * b (ti - tj) with b the inverse of their reactance, taps and resistance are
+ * ignored
+ *
+ * The problem is solved with a Mehrotra predictor corrector interior point
+ * method. The variables are the angles of the non slack buses and the
+ * generator outputs, the equalities are the bus balances, and the bounds and
+ * flow limits are inequalities with slacks. The slacks and their multipliers
+ * are eliminated, leaving the symmetric indefinite system
+ *
+ *   | H + G'(Z/S)G + r   A' | | dx |
+ *   | A                 -r | | w  |
+ *
+ * whose structure only depends on the topology and on which limits are
+ * finite. It is analyzed once and refactored on every iteration of every
+ * solve, it is only analyzed again when the set of limits changes. Each
+ * solve starts from the solution of the previous one, the slacks and
+ * multipliers pulled off the bounds by %warm_shift, so consecutive hourly
+ * problems take a few iterations each
+ *===========================================================================*/
+struct DcOpf {
+  //data ----------------------------------------------------------------------
+  Grid              *G;
+  vector<Branch*>   branches;       //lines then transformers
+  vector<sindex>    ti;             //angle variable of each bus, -1 slack
+  sindex            nt{0},          //angle variables
+                    nx{0},          //angles then generator outputs
+                    nc{0};          //inequalities
+  vector<int>       shape;          //limits the structure was built for
+
+  SMatrix<double>   A{0,0},         //bus balances, B theta - Ag pg = -d
+                    Gi{0,0},        //inequalities, Gi x <= h
+                    K{0,0};         //reduced KKT matrix, upper triangle
+  vector<sindex>    aslot,          //K slot of each value of A
+                    kdiag,          //K slot of each diagonal
+                    gpair,          //Gi slot pairs and the K slot they feed
+                    goff;           //offset of each inequality into %gpair
+  vector<sindex>    bslot,          //A slots of the four terms of a branch
+                    pslot;          //A slot of each generator output
+  vector<double>    bb,             //susceptance of each branch
+                    bal,            //right hand side of the balances
+                    h, c, q;        //limits, linear and quadratic costs
+
+  vector<double>    x, y, s, z;     //primal, balance multipliers, slacks
+                                    //and inequality multipliers
+  bool              warm{false};    //x, y, s, z hold the last solution
+
+  //results of the last solve, per unit
+  vector<double>    theta,          //bus angles, radians
+                    pg,             //output of each generator
+                    flow,           //from b[0] to b[1] along each branch
+                    lmp;            //marginal cost of demand at each bus
+  double            cost{0};
+  int               iterations{0};
+
+  double            tol{1e-8},
+                    step_fraction{0.995},
+                    warm_shift{1e-3},
+                    reg{1e-9};
+  int               max_iter{50};
+
+  _MKL_DSS_HANDLE_t mkl_handle;
+  bool analyzed{false};
+  _INTEGER_t mkl_err{ MKL_DSS_SUCCESS };
+  _INTEGER_t
+    dss_opt{ MKL_DSS_MSG_LVL_WARNING +
+             MKL_DSS_TERM_LVL_ERROR +
+             MKL_DSS_ZERO_BASED_INDEXING
+           },
+    dss_struct_opt{ MKL_DSS_SYMMETRIC },
+    dss_reorder_opt{ MKL_DSS_AUTO_ORDER },
+    dss_factor_opt{ MKL_DSS_INDEFINITE },
+    dss_solve_opt{ MKL_DSS_DEFAULTS };
+
+  //constructors --------------------------------------------------------------
+  explicit DcOpf(Grid *g);
+  ~DcOpf();
+  DcOpf(const DcOpf &) = delete;
+  DcOpf & operator=(const DcOpf &) = delete;
+
+  //methods -------------------------------------------------------------------
+  //dispatches against the active @demand of each bus in per unit, returns
+  //true if the interior point method converged within %max_iter iterations
+  bool solve(const double *demand);
+
+  //the limits currently set on the grid, the structure is rebuilt when they
+  //differ from %shape
+  vector<int> limits() const;
+
+  //builds A, Gi and the pattern of K for the current limits
+  void build();
+
+  //refreshes the values of A, Gi, %bal, h, c and q from the grid
+  void update(const double *demand);
+
+  //factors K for the multipliers at the current point
+  void factor();
+
+  //solves K [dx; w] = [r1; r2] in place, w = -dy
+  void kktSolve(vector<double> &r);
+
+  void mkl_death();
+};
+
+}
+
+#endif
@@ -0,0 +1,330 @@
+#include "Decomposition.hxx"
+#include <algorithm>
+#include <deque>
+
+using namespace gridworks;
+using std::deque;
+using std::runtime_error;
+using std::logic_error;
+using std::to_string;
+
+//breadth first order of the buses in @set starting at @start, buses that are
+//not reachable from @start are appended component by component
+static vector<int> bfsOrder(Grid &g, const vector<int> &set, int start,
+                            vector<int> &stamp, int in, int seen)
+{
+  vector<int> order;
+  order.reserve(set.size());
+  deque<int> q;
+
+  auto visit =
+  [&](int s)
+  {
+    stamp[s] = seen;
+    q.push_back(s);
+    while(!q.empty()) {
+      int i = q.front(); q.pop_front();
+      order.push_back(i);
+      for(const Neighbor &nbr : g.buses[i]->neighbors) {
+        int j = nbr.b->id;
+        if(stamp[j] == in) { stamp[j] = seen; q.push_back(j); }
+      }
+    }
+  };
+
+  visit(start);
+  for(int s : set) { if(stamp[s] == in) { visit(s); } }
+  return order;
+}
+
+static void bisect(Grid &g, const vector<int> &set, int first, int k,
+                   vector<int> &part, vector<int> &stamp, int &label)
+{
+  if(k == 1 || set.size() < 2) {
+    for(int i : set) { part[i] = first; }
+    return;
+  }
+
+  //a second sweep from the far end of the first one starts the split at a
+  //pseudo peripheral bus, which keeps the two halves compact
+  int in = ++label;
+  for(int i : set) { stamp[i] = in; }
+  vector<int> order = bfsOrder(g, set, set[0], stamp, in, ++label);
+  in = label;
+  order = bfsOrder(g, set, order.back(), stamp, in, ++label);
+
+  int k0 = k / 2;
+  size_t cut = set.size() * k0 / k;
+  vector<int> left(order.begin(), order.begin() + cut),
+              right(order.begin() + cut, order.end());
+
+  bisect(g, left, first, k0, part, stamp, label);
+  bisect(g, right, first + k0, k - k0, part, stamp, label);
+}
+
+vector<int> gridworks::partition(Grid &g, int k)
+{
+  if(k < 1) { throw runtime_error("partition count must be positive"); }
+
+  size_t n = g.buses.size();
+  vector<int> part(n, 0), stamp(n, 0), set(n);
+  for(size_t i=0; i<n; ++i) { set[i] = i; }
+  int label{0};
+  bisect(g, set, 0, k, part, stamp, label);
+  return part;
+}
+
+//DomainSolver ----------------------------------------------------------------
+
+DomainSolver::DomainSolver(Jacobi &J, int k)
+  : J{&J}, bus_part{partition(*J.g, k)}, domains(k)
+{
+  Grid &g = *J.g;
+  SMatrix<double> &M = *J.m;
+
+  //a bus becomes an interface bus if it has a neighbor in a lower numbered
+  //subdomain, that leaves no jacobean coupling between different interiors
+  vector<int> part = bus_part;
+  for(size_t i=0; i<g.buses.size(); ++i) {
+    for(const Neighbor &nbr : g.buses[i]->neighbors) {
+      if(part[nbr.b->id] < part[i]) { bus_part[i] = k; break; }
+    }
+  }
+
+  //owner and local index of each jacobean unknown
+  vector<int> owner(M.n, -1);
+  vector<sindex> local(M.n, -1);
+  for(size_t i=0; i<g.buses.size(); ++i) {
+    Bus &b = *g.buses[i];
+    if(!b.slack) { owner[b.jidx[0]] = bus_part[i]; }
+    if(b.qRow()) { owner[b.jidx[1]] = bus_part[i]; }
+  }
+  for(sindex u=0; u<M.n; ++u) {
+    if(owner[u] == k) {
+      local[u] = iface.size();
+      iface.push_back(u);
+    }
+    else {
+      Subdomain &D = domains[owner[u]];
+      local[u] = D.idx.size();
+      D.idx.push_back(u);
+    }
+  }
+
+  //split the jacobean entries into the blocks they belong to
+  vector<vector<sindex>> A_cnt(k);
+  for(int d=0; d<k; ++d) { A_cnt[d].assign(domains[d].idx.size() + 1, 0); }
+  for(sindex row=0; row<M.n; ++row) {
+    int ro = owner[row];
+    for(sindex e=M.r[row]; e<M.r[row+1]; ++e) {
+      sindex col = M.c[e];
+      int co = owner[col];
+      if(ro == k && co == k) {
+        S_row.push_back(local[row]);
+        S_col.push_back(local[col]);
+        S_src.push_back(e);
+      }
+      else if(ro == k) {
+        Subdomain &D = domains[co];
+        D.C_row.push_back(local[row]);
+        D.C_col.push_back(local[col]);
+        D.C_src.push_back(e);
+      }
+      else if(co == k) {
+        Subdomain &D = domains[ro];
+        D.B_row.push_back(local[row]);
+        D.B_col.push_back(local[col]);
+        D.B_src.push_back(e);
+      }
+      else if(ro == co) {
+        domains[ro].A_src.push_back(e);
+        ++A_cnt[ro][local[row]+1];
+      }
+      else {
+        throw logic_error("jacobean couples subdomains " + to_string(ro) +
+            " and " + to_string(co) + " directly");
+      }
+    }
+  }
+
+  for(int d=0; d<k; ++d) {
+    Subdomain &D = domains[d];
+    sindex ni = D.idx.size();
+
+    //interior block, rows arrive in order so the slots are already in csr
+    //order and the columns stay sorted since local indices are monotone
+    D.A = SMatrix<double>(ni, D.A_src.size());
+    D.A.r[0] = 0;
+    for(sindex i=0; i<ni; ++i) { D.A.r[i+1] = D.A.r[i] + A_cnt[d][i+1]; }
+    for(size_t e=0; e<D.A_src.size(); ++e) {
+      D.A.c[e] = local[M.c[D.A_src[e]]];
+    }
+
+    //interface columns of B, B_col is rewritten as a position in bcols
+    D.bcols = D.B_col;
+    std::sort(D.bcols.begin(), D.bcols.end());
+    D.bcols.erase(std::unique(D.bcols.begin(), D.bcols.end()),
+                  D.bcols.end());
+    for(sindex &c : D.B_col) {
+      c = std::lower_bound(D.bcols.begin(), D.bcols.end(), c)
+          - D.bcols.begin();
+    }
+
+    D.W.assign(ni * D.bcols.size(), 0);
+    D.y.assign(ni, 0);
+    D.r.assign(std::max<size_t>(ni, ni * D.bcols.size()), 0);
+  }
+
+  S.assign(iface.size() * iface.size(), 0);
+  S_piv.assign(iface.size(), 0);
+  xs.assign(iface.size(), 0);
+}
+
+DomainSolver::~DomainSolver()
+{
+  for(Subdomain &D : domains) {
+    if(D.analyzed) { dss_delete(D.handle, dss_solve_opt); }
+  }
+}
+
+void DomainSolver::mkl_death()
+{
+  throw runtime_error{
+    "MKL has exploded with error: " + to_string(mkl_err)
+  };
+}
+
+void DomainSolver::factor()
+{
+  const double *jv = J->m->v;
+  int nd = domains.size(), count{0};
+  _INTEGER_t failed{ MKL_DSS_SUCCESS };
+
+  #pragma omp parallel for schedule(dynamic) reduction(+:count)
+  for(int d=0; d<nd; ++d) {
+    Subdomain &D = domains[d];
+    sindex ni = D.idx.size(), nb = D.bcols.size();
+    if(ni == 0) { continue; }
+
+    //skip the refactorization if neither A nor B changed
+    size_t na = D.A_src.size();
+    vector<double> cur(na + D.B_src.size());
+    for(size_t e=0; e<na; ++e) { cur[e] = jv[D.A_src[e]]; }
+    for(size_t e=0; e<D.B_src.size(); ++e) { cur[na+e] = jv[D.B_src[e]]; }
+    if(D.analyzed && cur == D.last) { continue; }
+
+    _INTEGER_t err{ MKL_DSS_SUCCESS };
+    if(!D.analyzed) {
+      err = dss_create(D.handle, dss_opt);
+      if(err == MKL_DSS_SUCCESS) {
+        D.analyzed = true;
+        err = dss_define_structure(D.handle, dss_struct_opt,
+            D.A.r, D.A.n, D.A.n, D.A.c, D.A.s);
+      }
+      if(err == MKL_DSS_SUCCESS) {
+        err = dss_reorder(D.handle, dss_reorder_opt, 0);
+      }
+    }
+
+    std::copy(cur.begin(), cur.begin() + na, D.A.v);
+    if(err == MKL_DSS_SUCCESS) {
+      err = dss_factor_real(D.handle, dss_factor_opt, D.A.v);
+    }
+
+    //W = A^-1 B, one right hand side per touched interface unknown
+    if(err == MKL_DSS_SUCCESS && nb > 0) {
+      std::fill(D.r.begin(), D.r.end(), 0.0);
+      for(size_t e=0; e<D.B_src.size(); ++e) {
+        D.r[D.B_col[e]*ni + D.B_row[e]] = cur[na+e];
+      }
+      _INTEGER_t nrhs = nb;
+      err = dss_solve_real(D.handle, dss_solve_opt,
+          D.r.data(), nrhs, D.W.data());
+    }
+
+    if(err != MKL_DSS_SUCCESS) {
+      #pragma omp critical
+      failed = err;
+      D.last.clear();
+      continue;
+    }
+    D.last.swap(cur);
+    ++count;
+  }
+  refactored = count;
+  if(failed != MKL_DSS_SUCCESS) { mkl_err = failed; mkl_death(); }
+
+  //Schur complement S = A_ss - sum C_d W_d
+  sindex ns = iface.size();
+  if(ns == 0) { return; }
+  std::fill(S.begin(), S.end(), 0.0);
+  for(size_t e=0; e<S_src.size(); ++e) {
+    S[S_row[e]*ns + S_col[e]] += jv[S_src[e]];
+  }
+  for(const Subdomain &D : domains) {
+    sindex ni = D.idx.size(), nb = D.bcols.size();
+    for(size_t e=0; e<D.C_src.size(); ++e) {
+      double c = jv[D.C_src[e]];
+      double *srow = &S[D.C_row[e]*ns];
+      for(sindex q=0; q<nb; ++q) {
+        srow[D.bcols[q]] -= c * D.W[q*ni + D.C_col[e]];
+      }
+    }
+  }
+
+  sindex info = LAPACKE_dgetrf(LAPACK_ROW_MAJOR, ns, ns, S.data(), ns,
+                               S_piv.data());
+  if(info != 0) {
+    throw runtime_error("interface Schur complement is singular at " +
+        to_string(info));
+  }
+}
+
+void DomainSolver::solve(const double *b, double *x)
+{
+  int nd = domains.size();
+  _INTEGER_t failed{ MKL_DSS_SUCCESS };
+
+  //interior solves y_d = A_d^-1 b_d
+  #pragma omp parallel for schedule(dynamic)
+  for(int d=0; d<nd; ++d) {
+    Subdomain &D = domains[d];
+    sindex ni = D.idx.size();
+    if(ni == 0) { continue; }
+    for(sindex i=0; i<ni; ++i) { D.r[i] = b[D.idx[i]]; }
+    _INTEGER_t nrhs{1};
+    _INTEGER_t err =
+      dss_solve_real(D.handle, dss_solve_opt, D.r.data(), nrhs, D.y.data());
+    if(err != MKL_DSS_SUCCESS) {
+      #pragma omp critical
+      failed = err;
+    }
+  }
+  if(failed != MKL_DSS_SUCCESS) { mkl_err = failed; mkl_death(); }
+
+  //interface solve S x_s = b_s - sum C_d y_d
+  sindex ns = iface.size();
+  for(sindex s=0; s<ns; ++s) { xs[s] = b[iface[s]]; }
+  for(const Subdomain &D : domains) {
+    for(size_t e=0; e<D.C_src.size(); ++e) {
+      xs[D.C_row[e]] -= J->m->v[D.C_src[e]] * D.y[D.C_col[e]];
+    }
+  }
+  if(ns > 0) {
+    LAPACKE_dgetrs(LAPACK_ROW_MAJOR, 'N', ns, 1, S.data(), ns,
+                   S_piv.data(), xs.data(), 1);
+  }
+  for(sindex s=0; s<ns; ++s) { x[iface[s]] = xs[s]; }
+
+  //back substitution x_d = y_d - W_d x_s
+  #pragma omp parallel for schedule(dynamic)
+  for(int d=0; d<nd; ++d) {
+    const Subdomain &D = domains[d];
+    sindex ni = D.idx.size(), nb = D.bcols.size();
+    for(sindex i=0; i<ni; ++i) {
+      double acc = D.y[i];
+      for(sindex q=0; q<nb; ++q) { acc -= D.W[q*ni + i] * xs[D.bcols[q]]; }
+      x[D.idx[i]] = acc;
+    }
+  }
+}
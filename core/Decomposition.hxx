@@ -0,0 +1,93 @@
+#ifndef GW_DECOMPOSITION
+#define GW_DECOMPOSITION
+
+#include "Grid.hxx"
+#include <mkl_dss.h>
+#include <stdexcept>
+#include <string>
+
+namespace gridworks {
+
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * The $partition function splits the buses of @g into @k connected pieces of
+ * roughly equal size by recursive breadth first bisection over the
+ * %Bus::neighbors graph, the result holds the part of each bus
+ *~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~*/
+vector<int> partition(Grid &g, int k);
+
+/*=============================================================================
+ * A #Subdomain is the interior block of a #DomainSolver along with its
+ * coupling to the interface unknowns
+ *===========================================================================*/
+struct Subdomain {
+  //data ----------------------------------------------------------------------
+  vector<sindex>    idx;        //jacobean index of each interior unknown
+  SMatrix<double>   A{0,0};     //interior block
+  vector<sindex>    A_src;      //jacobean value slot of each entry of A
+  vector<sindex>    B_row,      //interior rows of the interior-interface
+                    B_col,      //block, interface columns and value slots
+                    B_src;
+  vector<sindex>    C_row,      //interface rows of the interface-interior
+                    C_col,      //block, interior columns and value slots
+                    C_src;
+  vector<sindex>    bcols;      //interface unknowns this domain touches
+  vector<double>    W,          //A^-1 B restricted to %bcols, column major
+                    y,          //interior solve scratch
+                    r,
+                    last;       //values of A and B at the last factorization
+  _MKL_DSS_HANDLE_t handle;
+  bool              analyzed{false};
+};
+
+/*=============================================================================
+ * The #DomainSolver solves the newton system of a #Jacobi by domain
+ * decomposition. The buses are partitioned into k subdomains separated by a
+ * set of interface buses, each subdomain block is factored independently and
+ * in parallel and the interface unknowns are solved from the dense Schur
+ * complement. Subdomains whose jacobean block did not change since the last
+ * factorization are not refactored
+ *===========================================================================*/
+struct DomainSolver {
+  //data ----------------------------------------------------------------------
+  Jacobi              *J;         //the jacobean being solved
+  vector<int>         bus_part;   //subdomain of each bus, k for interface
+  vector<Subdomain>   domains;    //the interior blocks
+  vector<sindex>      iface;      //jacobean index of each interface unknown
+  vector<sindex>      S_row,      //interface-interface block entries
+                      S_col,
+                      S_src;
+  vector<double>      S;          //dense Schur complement, row major
+  vector<sindex>      S_piv;      //pivots of the factored Schur complement
+  vector<double>      xs;         //interface solve scratch
+  int                 refactored{0}; //subdomains refactored last factor()
+
+  _INTEGER_t mkl_err{ MKL_DSS_SUCCESS };
+  _INTEGER_t
+    dss_opt{ MKL_DSS_MSG_LVL_WARNING +
+             MKL_DSS_TERM_LVL_ERROR +
+             MKL_DSS_ZERO_BASED_INDEXING
+           },
+    dss_struct_opt{ MKL_DSS_NON_SYMMETRIC },
+    dss_reorder_opt{ MKL_DSS_AUTO_ORDER },
+    dss_factor_opt{ MKL_DSS_INDEFINITE },
+    dss_solve_opt{ MKL_DSS_DEFAULTS };
+
+  //constructors --------------------------------------------------------------
+  DomainSolver(Jacobi &J, int k);
+  ~DomainSolver();
+  DomainSolver(const DomainSolver &) = delete;
+  DomainSolver & operator=(const DomainSolver &) = delete;
+
+  //methods -------------------------------------------------------------------
+  //factors the subdomain blocks whose values changed and the Schur complement
+  void factor();
+
+  //solves J x = b using the current factorization
+  void solve(const double *b, double *x);
+
+  void mkl_death();
+};
+
+}
+
+#endif
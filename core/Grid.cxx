@@ -1,4 +1,5 @@
 #include "Grid.hxx"
+#include "SymbolicCache.hxx"
 
 using namespace gridworks;
 
@@ -23,6 +24,16 @@ Neighbor::Neighbor(Branch *br , Bus *b) : br{br}, b{b} {}
 Bus::Bus(int id, double rating, complex shunt_y) 
   : id{id}, rating{rating}, shunt_y{shunt_y} {}
 
+bool Bus::vControlled() const 
+{ 
+  return generator != nullptr && qlim == QLimit::None; 
+}
+
+bool Bus::qRow() const
+{
+  return generator == nullptr || (!slack && generator->qLimited());
+}
+
 Branch::Branch(Kind kind) : kind{kind} {}
   
 void Branch::connect(Bus *b0, Bus *b1){ 
@@ -39,6 +50,19 @@ SimpleLine::SimpleLine(complex impedance, complex charging_admittance)
 complex SimpleLine::z() const { return _z; }
 complex SimpleLine::cy() { return _cy; }
   
+//mean self less mean mutual term of a phase matrix
+static complex positiveSequence(const array<complex, 9> &m)
+{
+  return (m[0] + m[4] + m[8]) / 3.0 - (m[1] + m[5] + m[6]) / 3.0;
+}
+
+ThreePhaseLine::ThreePhaseLine(array<complex, 9> zabc,
+    array<complex, 9> yabc)
+  : zabc(zabc), yabc(yabc) {}
+
+complex ThreePhaseLine::z() const { return positiveSequence(zabc); }
+complex ThreePhaseLine::cy() { return positiveSequence(yabc); }
+  
 SimpleTransformer::SimpleTransformer(complex impedance, complex turns_ratio)
   : _z{impedance}, _tr{turns_ratio} {}
 
@@ -47,9 +71,132 @@ Transformer::Transformer() : Branch(Kind::Transformer) {}
 complex SimpleTransformer::z() const { return _z; }
 complex SimpleTransformer::tr() { return _tr; }
   
+bool Generator::qLimited() const
+{
+  return std::isfinite(qmin) || std::isfinite(qmax);
+}
+
 StaticGen::StaticGen(complex v) : _v{v} {}
 complex StaticGen::v(double) const { return _v; }
 
+ClassicalGen::ClassicalGen(complex v, double H, double D, double xdp)
+  : _v{v}, H{H}, D{D}, xdp{xdp}
+{
+  kind = Kind::Classical;
+}
+
+complex ClassicalGen::v(double) const { return _v; }
+
+FourthOrderGen::FourthOrderGen(complex v, double H, double D, double xd,
+    double xq, double xdp, double xqp, double Td0p, double Tq0p)
+  : ClassicalGen(v, H, D, xdp), xd{xd}, xq{xq}, xqp{xqp},
+    Td0p{Td0p}, Tq0p{Tq0p}
+{
+  kind = Kind::FourthOrder;
+}
+
+Load::Load(Kind kind, complex s0) : kind{kind}, s0{s0} {}
+
+ZipLoad::ZipLoad(complex s0, array<double, 3> p, array<double, 3> q)
+  : Load(Kind::ZIP, s0), p(p), q(q) {}
+
+ExponentialLoad::ExponentialLoad(complex s0, double np, double nq)
+  : Load(Kind::Exponential, s0), np{np}, nq{nq} {}
+
+LoadValues::LoadValues(size_t n) : n{n}, p(n), q(n), dp(n), dq(n) {}
+
+LoadBlock::LoadBlock(const vector<Load*> &loads)
+  : n{loads.size()}, bus(n),
+    p0(n), q0(n), vn(n),
+    zp(n), ip(n), pp(n), ep(n),
+    zq(n), iq(n), pq(n), eq(n)
+{
+  for(size_t k=0; k<n; ++k)
+  {
+    const Load &l = *loads[k];
+    bus[k] = l.bus_id;
+    p0[k] = l.s0.real();
+    q0[k] = l.s0.imag();
+    vn[k] = l.vn;
+    switch(l.kind)
+    {
+      case Load::Kind::ZIP:
+      {
+        const ZipLoad &z = static_cast<const ZipLoad&>(l);
+        zp[k] = z.p[0]; ip[k] = z.p[1]; pp[k] = z.p[2]; ep[k] = 0;
+        zq[k] = z.q[0]; iq[k] = z.q[1]; pq[k] = z.q[2]; eq[k] = 0;
+        break;
+      }
+
+      case Load::Kind::Exponential:
+      {
+        const ExponentialLoad &e = static_cast<const ExponentialLoad&>(l);
+        zp[k] = 0; ip[k] = 0; pp[k] = 1; ep[k] = e.np;
+        zq[k] = 0; iq[k] = 0; pq[k] = 1; eq[k] = e.nq;
+        break;
+      }
+    }
+  }
+
+  //loads by bus, counting sort keeps them in load order
+  int nb{0};
+  for(size_t k=0; k<n; ++k) { nb = std::max(nb, bus[k] + 1); }
+  bbeg.assign(nb + 1, 0);
+  for(size_t k=0; k<n; ++k) { ++bbeg[bus[k] + 1]; }
+  for(int i=0; i<nb; ++i) { bbeg[i+1] += bbeg[i]; }
+  bload.resize(n);
+  vector<int> at(bbeg.begin(), bbeg.end() - 1);
+  for(size_t k=0; k<n; ++k) { bload[at[bus[k]]++] = k; }
+}
+
+void LoadBlock::evaluate(const complex *v, LoadValues &out) const
+{
+  if(out.n != n) { out = LoadValues(n); }
+  const double *vd = reinterpret_cast<const double*>(v);
+  const int *b = bus.data;
+  const double *p0_ = p0.data, *q0_ = q0.data, *vn_ = vn.data,
+               *zp_ = zp.data, *ip_ = ip.data, *pp_ = pp.data, *ep_ = ep.data,
+               *zq_ = zq.data, *iq_ = iq.data, *pq_ = pq.data, *eq_ = eq.data;
+  double *p_ = out.p.data, *q_ = out.q.data,
+         *dp_ = out.dp.data, *dq_ = out.dq.data;
+  long m = n;
+
+  #pragma omp parallel for simd
+  for(long k=0; k<m; ++k)
+  {
+    double vr = vd[2*b[k]], vi = vd[2*b[k]+1],
+           u = std::sqrt(vr*vr + vi*vi) / vn_[k],
+           u2 = u*u,
+           up = std::pow(u, ep_[k]),
+           uq = std::pow(u, eq_[k]);
+    p_[k] = p0_[k] * (zp_[k]*u2 + ip_[k]*u + pp_[k]*up);
+    q_[k] = q0_[k] * (zq_[k]*u2 + iq_[k]*u + pq_[k]*uq);
+    dp_[k] = p0_[k] * (2.0*zp_[k]*u2 + ip_[k]*u + ep_[k]*pp_[k]*up);
+    dq_[k] = q0_[k] * (2.0*zq_[k]*u2 + iq_[k]*u + eq_[k]*pq_[k]*uq);
+  }
+}
+
+void LoadBlock::evaluate(const complex *v, size_t k, LoadValues &out) const
+{
+  if(out.n != n) { out = LoadValues(n); }
+  double u = std::abs(v[bus.data[k]]) / vn.data[k],
+         u2 = u*u,
+         up = std::pow(u, ep.data[k]),
+         uq = std::pow(u, eq.data[k]);
+  const double *p0_ = p0.data, *q0_ = q0.data,
+               *zp_ = zp.data, *ip_ = ip.data, *pp_ = pp.data, *ep_ = ep.data,
+               *zq_ = zq.data, *iq_ = iq.data, *pq_ = pq.data, *eq_ = eq.data;
+  out.p[k] = p0_[k] * (zp_[k]*u2 + ip_[k]*u + pp_[k]*up);
+  out.q[k] = q0_[k] * (zq_[k]*u2 + iq_[k]*u + pq_[k]*uq);
+  out.dp[k] = p0_[k] * (2.0*zp_[k]*u2 + ip_[k]*u + ep_[k]*pp_[k]*up);
+  out.dq[k] = q0_[k] * (2.0*zq_[k]*u2 + iq_[k]*u + eq_[k]*pq_[k]*uq);
+}
+
+void Grid::gatherLoads()
+{
+  loadBlock = LoadBlock(loads);
+}
+
 Glob<complex> Grid::sCalc(Glob<complex> x, SMatrix<complex> Y)
 {
   using std::abs;
@@ -84,7 +231,7 @@ Glob<complex> Grid::sCalc(Glob<complex> x, SMatrix<complex> Y)
 
     sCalc.data[i] = {P,Q};
   }
-  
+
   return sCalc;
 
 }
@@ -98,6 +245,31 @@ Glob<complex> Grid::flatStart() {
   return x;
 }
 
+PiModel gridworks::piModel(Branch &br) {
+  switch(br.kind)
+  {
+    case Branch::Kind::Line:
+    {
+      Line &l = static_cast<Line&>(br);
+      complex y = 1.0/l.z(),
+              ys = y + 0.5 * l.cy();
+      return {ys, -y, -y, ys};
+    }
+
+    case Branch::Kind::Transformer:
+    {
+      //the off nominal turns ratio is seen from the higher rated side
+      Transformer &t = static_cast<Transformer&>(br);
+      complex y = 1.0/t.z(),
+              yt = std::pow(std::abs(1.0/t.tr().real()), 2)*y,
+              ym = -(1.0/t.tr().real())*y;
+      return {br.b[0]->rating > br.b[1]->rating ? yt : y, ym, ym,
+              br.b[1]->rating > br.b[0]->rating ? yt : y};
+    }
+  }
+  return {};
+}
+
 SMatrix<complex> gridworks::ymatrix(Grid &g) {
 
   SMatrix<complex> m(g.buses.size(), 
@@ -124,28 +296,16 @@ SMatrix<complex> gridworks::ymatrix(Grid &g) {
     {
       Neighbor n = b.neighbors[j-1]; 
       m.c[off+j] = n.b->id;
-      switch(n.br->kind)
+      PiModel pi = piModel(*n.br);
+      if(n.br->b[0] == &b)
       {
-        case Branch::Kind::Line:
-        {
-          Line &l = *static_cast<Line*>(n.br);
-          complex y = 1.0/l.z();
-          m.v[off+j] = -y;
-          m.v[off] += y + 0.5 * l.cy();
-          break;
-        }
-
-        case Branch::Kind::Transformer:
-        {
-          Transformer &t = *static_cast<Transformer*>(n.br);
-          complex y = 1.0/t.z();
-          m.v[off+j] = -(1.0/t.tr().real())*y;
-          if(b.rating > n.b->rating)
-            m.v[off] += std::pow(std::abs(1.0/t.tr().real()), 2)*y;
-          else
-            m.v[off] += y;
-          break;
-        }
+        m.v[off+j] = pi.y01;
+        m.v[off] += pi.y00;
+      }
+      else
+      {
+        m.v[off+j] = pi.y10;
+        m.v[off] += pi.y11;
       }
     }
   };
@@ -160,15 +320,46 @@ SMatrix<complex> gridworks::ymatrix(Grid &g) {
 
 
 
+uint64_t gridworks::topologyHash(const Grid &g)
+{
+  uint64_t h{14695981039346656037ull};
+  auto mix = [&h](uint64_t x)
+  {
+    for(int k=0; k<8; ++k)
+    {
+      h ^= (x >> 8*k) & 0xff;
+      h *= 1099511628211ull;
+    }
+  };
+
+  mix(g.buses.size());
+  for(const Bus *b : g.buses)
+  {
+    mix(b->slack | (b->generator != nullptr) << 1 | b->qRow() << 2);
+    mix(b->neighbors.size());
+    for(const Neighbor &nb : b->neighbors) { mix(nb.b->id); }
+  }
+  return h;
+}
+
+
+
 //Jacobi ----------------------------------------------------------------------
 
 
-Jacobi::Jacobi(Grid *g, SMatrix<complex> y, Glob<complex> x) 
-  :g(g), y{y}, x{x}
+Jacobi::Jacobi(Grid *g, SMatrix<complex> y, Glob<complex> x,
+               SymbolicCache *cache)
+  :g(g), y{y}, x{x}, topology{topologyHash(*g)}
 { 
-  computeStructureInfo();
-  m = std::make_shared<SMatrix<double>>(jsi.N(), jsi.S());
-  computeMapInfo();
+  if(g->loadBlock.n != g->loads.size()) { g->gatherLoads(); }
+  if(!cache || !cache->load(*this))
+  {
+    computeStructureInfo();
+    m = std::make_shared<SMatrix<double>>(jsi.N(), jsi.S());
+    computeMapInfo();
+    if(cache) { cache->store(*this); }
+  }
+  regroup();
   update();
 }
 
@@ -180,34 +371,35 @@ void Jacobi::computeStructureInfo() {
     Bus &b = *g->buses[i];
     if(!b.slack) {
       b.jidx[0] = jsi.n[0]++; jsi.s[0]++; 
-      if(!b.generator){ jsi.s[1]++; }
+      if(b.qRow()){ jsi.s[1]++; }
       for(size_t j=0; j<b.neighbors.size(); ++j) {
         Bus &o = *g->buses[b.neighbors[j].b->id];
         if(!o.slack) jsi.s[0]++;
-        if(!o.generator) jsi.s[1]++;
+        if(o.qRow()) jsi.s[1]++;
       }
     }
-    if(!b.generator) {
+    if(b.qRow()) {
       b.jidx[1] = jsi.n[1]++; 
       jsi.s[2]++; jsi.s[3]++;
       for(size_t j=0; j<b.neighbors.size(); ++j) {
         Bus &o = *g->buses[b.neighbors[j].b->id];
         if(!o.slack) jsi.s[2]++;
-        if(!o.generator) jsi.s[3]++;
+        if(o.qRow()) jsi.s[3]++;
       }
     }
   }
   for(size_t i=0; i<g->buses.size(); ++i)
   {
     Bus &b = *g->buses[i];
-    if(!b.generator) { b.jidx[1] += jsi.n[0]; }
+    if(b.qRow()) { b.jidx[1] += jsi.n[0]; }
   }
     
 }
 
 int qi_cmp (const void * a, const void * b)
 {
-  return ( *(MKL_INT*)a - *(MKL_INT*)b );
+  sindex x = *(const sindex*)a, y = *(const sindex*)b;
+  return (x > y) - (x < y);
 }
 
 void Jacobi::computeMapInfo() {
@@ -234,7 +426,7 @@ void Jacobi::computeMapInfo() {
   [this](Bus &b, int i) 
   {
     int x{0};
-    if(!b.generator)
+    if(b.qRow())
     {
       m->c[i++] = b.jidx[1];
       x++;
@@ -242,7 +434,7 @@ void Jacobi::computeMapInfo() {
     for(size_t j=0; j<b.neighbors.size(); ++j) 
     { 
       Bus &nbr = *g->buses[b.neighbors[j].b->id];
-      if(!nbr.generator) 
+      if(nbr.qRow()) 
       { 
         m->c[i++] = nbr.jidx[1];
         ++x;
@@ -267,7 +459,7 @@ void Jacobi::computeMapInfo() {
   for(size_t i=0; i<g->buses.size(); ++i)
   {
     Bus &b = *g->buses[i];
-    if(!b.generator) {
+    if(b.qRow()) {
       rv += s1(b, rv); 
       rv += s2(b, rv);
       m->r[ri++] = rv; 
@@ -278,87 +470,217 @@ void Jacobi::computeMapInfo() {
 
   for(int i=0; i<jsi.N(); ++i)
   {
-    qsort(&m->c[ m->r[i] ], m->r[i+1] - m->r[i], sizeof(MKL_INT), qi_cmp);
+    qsort(&m->c[ m->r[i] ], m->r[i+1] - m->r[i], sizeof(sindex), qi_cmp);
   }
 }
 
-void Jacobi::update()
+//BusBlocks -------------------------------------------------------------------
+
+BusKind gridworks::busKind(const Bus &b)
 {
-  auto gradient = 
-  [this](MKL_INT i)
-  {
-    Bus &b = *g->buses[i];
-    if(b.slack) { return; }
-    
-    SMatrix<complex> &Y = y;
-    SMatrix<double> &M = *m;
-    Glob<complex> &X = x;
+  if(b.slack) { return BusKind::Slack; }
+  if(!b.qRow()) { return BusKind::PV; }
+  return b.vControlled() ? BusKind::PVQ : BusKind::PQ;
+}
 
-    for(size_t ni=0; ni<b.neighbors.size(); ++ni)
-    {
-      int j = b.neighbors[ni].b->id;
-      Bus &nbr = *g->buses[j];
-      
-      double vi = std::abs(X[i]),
-             vj = std::abs(X[j]),
-             ym = std::abs(Y[{i,j}]),
-
-             ti = std::arg(X[i]),
-             tj = std::arg(X[j]),
-             ya = std::arg(Y[{i,j}]);
-      
-      double mag = vi * vj * ym,
-              ang = ya + tj - ti,
-
-              dPdA =  mag * sin(ang),
-              dPdM =  mag * cos(ang),
-              dQdA = -mag * cos(ang),
-              dQdM = -mag * sin(ang);
-
-      //dP
-      if(!b.slack)
-      {
-        M[{b.jidx[0], b.jidx[0]}] += dPdA;
-        if(!b.generator) { M[{b.jidx[0], b.jidx[1]}] += dPdM; }
-
-        if(!nbr.slack)
-        {
-          M[{b.jidx[0], nbr.jidx[0]}] = -dPdA;
-          if(!nbr.generator) { M[{b.jidx[0], nbr.jidx[1]}] = dPdM; }
-        }
-      }
+//position of (@r, @c) in @m, the first one as operator[] finds it, or @none
+//when the row or column does not exist
+template <class T>
+static sindex slot(const SMatrix<T> &m, sindex r, sindex c, sindex none)
+{
+  if(r < 0 || c < 0) { return none; }
+  for(sindex k=m.r[r]; k<m.r[r+1]; ++k) { if(m.c[k] == c) { return k; } }
+  throw std::out_of_range{
+    "CSR Out of Range (" + std::to_string(r) + "," + std::to_string(c) + ")"
+  };
+}
 
-      //dQ
-      if(!b.generator)
-      {
-        M[{b.jidx[1], b.jidx[0]}] -= dQdA;
-        if(!b.generator) { M[{b.jidx[1], b.jidx[1]}] += dQdM; }
-
-        if(!nbr.slack)
-        {
-          M[{b.jidx[1], nbr.jidx[0]}] = dQdA;
-          if(!nbr.generator) { M[{b.jidx[1], nbr.jidx[1]}] = dQdM; }
-        }
-      }
+void BusBlocks::build(Grid &g, SMatrix<complex> &y, SMatrix<double> &m)
+{
+  size_t n = g.buses.size();
+
+  //counting sort by kind, stable so each block keeps the natural order
+  size_t count[4]{0,0,0,0};
+  for(const Bus *b : g.buses) { ++count[static_cast<int>(busKind(*b))]; }
+  begin[0] = 0;
+  for(int k=0; k<4; ++k) { begin[k+1] = begin[k] + count[k]; }
+  order.resize(n);
+  size_t next[4]{begin[0], begin[1], begin[2], begin[3]};
+  for(size_t i=0; i<n; ++i) {
+    order[next[static_cast<int>(busKind(*g.buses[i]))]++] = i;
+  }
+  at.resize(n);
+  for(size_t k=0; k<n; ++k) { at[order[k]] = k; }
 
-    }
+  for(vector<sindex> *a : {&j0, &j1, &ydiag, &d00, &d01, &d10, &d11}) {
+    a->resize(n);
+  }
+  nbeg.assign(1, 0);
+  nbus.clear();
+  for(vector<sindex> *a : {&ypos, &o00, &o01, &o10, &o11}) { a->clear(); }
 
-    if(!b.generator)
+  for(size_t k=0; k<n; ++k)
+  {
+    const Bus &b = *g.buses[order[k]];
+    sindex none = m.s + k;          //scratch slot of this bus alone
+    sindex r0 = b.slack ? -1 : b.jidx[0],
+           r1 = b.qRow() ? b.jidx[1] : -1;
+    j0[k] = r0;
+    j1[k] = r1;
+    ydiag[k] = slot(y, order[k], order[k], -1);
+    d00[k] = slot(m, r0, r0, none);
+    d01[k] = slot(m, r0, r1, none);
+    d10[k] = slot(m, r1, r0, none);
+    d11[k] = slot(m, r1, r1, none);
+    for(const Neighbor &nb : b.neighbors)
     {
-      M[{b.jidx[0], b.jidx[1]}] 
-        += 2.0 * std::pow(std::abs(X[i]), 2) * Y[{i,i}].real();
+      const Bus &o = *nb.b;
+      sindex c0 = o.slack ? -1 : o.jidx[0],
+             c1 = o.qRow() ? o.jidx[1] : -1;
+      nbus.push_back(o.id);
+      ypos.push_back(slot(y, order[k], o.id, -1));
+      o00.push_back(slot(m, r0, c0, none));
+      o01.push_back(slot(m, r0, c1, none));
+      o10.push_back(slot(m, r1, c0, none));
+      o11.push_back(slot(m, r1, c1, none));
+    }
+    nbeg.push_back(nbus.size());
+  }
+
+  w.assign(m.s + n, 0.0);
+}
 
-      M[{b.jidx[1], b.jidx[1]}] 
-        -= 2.0 * std::pow(std::abs(X[i]), 2) * Y[{i,i}].imag();
+//the jacobian rows of the bus at position @k, the reactive row of a PVQ bus
+//is the identity so that its magnitude correction is zero. Every bus writes
+//only its own rows and its own scratch slot, which is never read, and adds to
+//its diagonal slots which must be cleared first
+template <BusKind K>
+static inline void jacobianRow(const BusBlocks &bb, size_t k,
+                               const complex *x, const complex *yv, double *w)
+{
+  const int *nbus = bb.nbus.data();
+  const sindex *nbeg = bb.nbeg.data(), *ypos = bb.ypos.data(),
+               *o00 = bb.o00.data(), *o01 = bb.o01.data(),
+               *o10 = bb.o10.data(), *o11 = bb.o11.data();
+
+  int i = bb.order[k];
+  double a00{0}, a01{0}, a10{0}, a11{0};
+  for(sindex n=nbeg[k]; n<nbeg[k+1]; ++n)
+  {
+    Partials d = partials(x[i], x[nbus[n]], yv[ypos[n]]);
+    a00 += d.dPdA;
+    a01 += d.dPdM;
+    w[o00[n]] = -d.dPdA;
+    w[o01[n]] = d.dPdM;
+    if(K == BusKind::PQ)
+    {
+      a10 -= d.dQdA;
+      a11 += d.dQdM;
+      w[o10[n]] = d.dQdA;
+      w[o11[n]] = d.dQdM;
     }
-  
-  };
-      
-  m->zero();
-  for(size_t i=0; i<g->buses.size(); ++i)
+  }
+
+  double v2 = 2.0 * std::pow(std::abs(x[i]), 2);
+  complex yii = yv[bb.ydiag[k]];
+  w[bb.d00[k]] += a00;
+  if(K != BusKind::PV) { w[bb.d01[k]] += a01 + v2 * yii.real(); }
+  if(K == BusKind::PQ)
+  {
+    w[bb.d10[k]] += a10;
+    w[bb.d11[k]] += a11 - v2 * yii.imag();
+  }
+  if(K == BusKind::PVQ) { w[bb.d11[k]] = 1.0; }
+}
+
+//the jacobian rows of the buses [@b, @e) of one block, they split over
+//@threads freely
+template <BusKind K>
+static void jacobianBlock(const BusBlocks &bb, size_t b, size_t e,
+                          const complex *x, const complex *yv, double *w,
+                          int threads)
+{
+  #pragma omp parallel for num_threads(threads) if(threads > 1)
+  for(size_t k=b; k<e; ++k) { jacobianRow<K>(bb, k, x, yv, w); }
+}
+
+void Jacobi::regroup()
+{
+  blocks.build(*g, y, *m);
+}
+
+void Jacobi::update()
+{
+  BusBlocks &bb = blocks;
+  SMatrix<double> &M = *m;
+  std::fill(bb.w.begin(), bb.w.end(), 0.0);
+  jacobianBlock<BusKind::PV>(bb, bb.first(BusKind::PV), bb.last(BusKind::PV),
+                             x.data, y.v, bb.w.data(), threads);
+  jacobianBlock<BusKind::PVQ>(bb, bb.first(BusKind::PVQ),
+                              bb.last(BusKind::PVQ), x.data, y.v, bb.w.data(),
+                              threads);
+  jacobianBlock<BusKind::PQ>(bb, bb.first(BusKind::PQ), bb.last(BusKind::PQ),
+                             x.data, y.v, bb.w.data(), threads);
+  std::copy(bb.w.begin(), bb.w.begin() + M.s, M.v);
+
+  //voltage dependent loads only add to the magnitude column of their own bus
+  const LoadBlock &lb = g->loadBlock;
+  if(lb.n == 0) { return; }
+  lb.evaluate(x.data, loads);
+  for(size_t k=0; k<lb.n; ++k)
   {
-    gradient(i);
+    const Bus &b = *g->buses[lb.bus.data[k]];
+    if(b.slack || !b.qRow() || b.vControlled()) { continue; }
+    M[{b.jidx[0], b.jidx[1]}] += loads.dp[k];
+    M[{b.jidx[1], b.jidx[1]}] += loads.dq[k];
   }
 
+}
+
+void Jacobi::update(const vector<int> &buses)
+{
+  BusBlocks &bb = blocks;
+  SMatrix<double> &M = *m;
+  const LoadBlock &lb = g->loadBlock;
+  double *w = bb.w.data();
 
+  auto keep = [&](sindex slot) { if(slot < M.s) { M.v[slot] = w[slot]; } };
+  for(int i : buses)
+  {
+    size_t k = bb.at[i];
+    BusKind kind = bb.kind(k);
+    if(kind == BusKind::Slack) { continue; }
+
+    for(sindex slot : {bb.d00[k], bb.d01[k], bb.d10[k], bb.d11[k]}) {
+      w[slot] = 0;
+    }
+    switch(kind)
+    {
+      case BusKind::PV: jacobianRow<BusKind::PV>(bb, k, x.data, y.v, w); break;
+      case BusKind::PVQ:
+        jacobianRow<BusKind::PVQ>(bb, k, x.data, y.v, w);
+        break;
+      default: jacobianRow<BusKind::PQ>(bb, k, x.data, y.v, w); break;
+    }
+    for(sindex slot : {bb.d00[k], bb.d01[k], bb.d10[k], bb.d11[k]}) {
+      keep(slot);
+    }
+    for(sindex n=bb.nbeg[k]; n<bb.nbeg[k+1]; ++n)
+    {
+      keep(bb.o00[n]);
+      keep(bb.o01[n]);
+      keep(bb.o10[n]);
+      keep(bb.o11[n]);
+    }
+
+    //as in update, only PQ buses take the voltage dependence of their loads
+    if(kind != BusKind::PQ || i + 1 >= int(lb.bbeg.size())) { continue; }
+    for(int l=lb.bbeg[i]; l<lb.bbeg[i+1]; ++l)
+    {
+      size_t ld = lb.bload[l];
+      lb.evaluate(x.data, ld, loads);
+      M.v[bb.d01[k]] += loads.dp[ld];
+      M.v[bb.d11[k]] += loads.dq[ld];
+    }
+  }
 }
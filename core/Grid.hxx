@@ -7,6 +7,8 @@
 #include <cmath>
 #include <vector>
 #include <array>
+#include <limits>
+#include <cstdint>
 
 namespace gridworks {
 
@@ -24,6 +26,57 @@ struct Bus;
 struct Generator;
 struct Load;
 struct ShuntCap;
+struct SymbolicCache;
+
+/*=============================================================================
+ * #LoadValues holds the consumption of the loads of a #LoadBlock at one set
+ * of voltages. Each solver keeps its own so that evaluating the loads leaves
+ * the #Grid untouched
+ *===========================================================================*/
+struct LoadValues {
+  //data ----------------------------------------------------------------------
+  size_t        n{0};
+  Glob<double>  p, q,                   //consumption
+                dp, dq;                 //u dP/du and u dQ/du, the
+                                        //derivatives w.r.t. the relative
+                                        //magnitude used by the jacobean
+
+  //constructors --------------------------------------------------------------
+  LoadValues() = default;
+  explicit LoadValues(size_t n);
+};
+
+/*=============================================================================
+ * A #LoadBlock is a flat, structure of arrays copy of the voltage dependent
+ * #Load objects of a #Grid. Every load is evaluated with the one form
+ *
+ *   P = P0 (zp u^2 + ip u + pp u^ep),  u = |V| / vn
+ *
+ * and likewise for Q, a ZIP load has ep = 0 and an exponential load has
+ * zp = ip = 0 and pp = 1, so the whole block is evaluated in one vectorized
+ * loop without dispatching on the kind of each load
+ *===========================================================================*/
+struct LoadBlock {
+  //data ----------------------------------------------------------------------
+  size_t        n{0};
+  Glob<int>     bus;
+  Glob<double>  p0, q0, vn,             //nominal consumption and voltage
+                zp, ip, pp, ep,         //active shares and exponent
+                zq, iq, pq, eq;         //reactive shares and exponent
+  vector<int>   bbeg, bload;            //loads of bus i are bload[bbeg[i]]
+                                        //to bload[bbeg[i+1]], in order
+
+  //constructors --------------------------------------------------------------
+  LoadBlock() = default;
+  explicit LoadBlock(const vector<Load*> &loads);
+
+  //methods -------------------------------------------------------------------
+  //evaluates every load at the bus voltages @v into @out
+  void evaluate(const complex *v, LoadValues &out) const;
+
+  //evaluates load @k alone
+  void evaluate(const complex *v, size_t k, LoadValues &out) const;
+};
 
 /*=============================================================================
  * A #Grid is a composition of #Bus, #Line, #Transformer, #Generator and 
@@ -37,10 +90,18 @@ struct Grid {
   vector<Transformer*>  transformers;
   vector<Generator*>    generators;
   vector<Load*>         loads;
+  LoadBlock             loadBlock;  //flat copy of loads, see gatherLoads
 
   //methods -------------------------------------------------------------------
+  //the power the network draws out of each bus, the voltage dependent loads
+  //are not included
   Glob<complex> sCalc(Glob<complex> state, SMatrix<complex> Y);
   Glob<complex> flatStart();
+
+  //rebuilds loadBlock from loads, a jacobian gathers it when it is built if
+  //the number of loads changed, call it after editing the loads of a grid
+  //that already has a solver
+  void gatherLoads();
 };
 
 /*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -49,6 +110,44 @@ struct Grid {
  *~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~*/
 SMatrix<complex> ymatrix(Grid &grid);
 
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * The $topologyHash function returns a 64 bit FNV-1a hash of the bus
+ * adjacency of @grid and of its slack, generator and reactive row
+ * assignment, everything the structure of the jacobian depends on
+ *~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~*/
+uint64_t topologyHash(const Grid &grid);
+
+/*=============================================================================
+ * #Partials holds the derivatives of the power flowing from bus i towards bus
+ * j through the admittance yij with respect to the voltage angles and the
+ * (relative) voltage magnitudes. %dPdM and %dQdM are also the active and
+ * reactive power terms themselves
+ *===========================================================================*/
+struct Partials {
+  double dPdA, dPdM, dQdA, dQdM;
+};
+
+inline Partials partials(complex vi, complex vj, complex yij)
+{
+  double mag = std::abs(vi) * std::abs(vj) * std::abs(yij),
+         ang = std::arg(yij) + std::arg(vj) - std::arg(vi);
+
+  return { mag * sin(ang), mag * cos(ang), -mag * cos(ang), -mag * sin(ang) };
+}
+
+/*=============================================================================
+ * A #PiModel is the two port admittance of a #Branch as it enters the
+ * admittance matrix, index 0 refers to the %Branch::b[0] side
+ *===========================================================================*/
+struct PiModel {
+  complex y00, y01, y10, y11;
+};
+
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * The $piModel function returns the two port admittance of @br
+ *~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~*/
+PiModel piModel(Branch &br);
+
 /*=============================================================================
  * The #Neighbor class connects a #Bus to a neighboring #Bus via a #Branch
  *===========================================================================*/
@@ -68,6 +167,10 @@ struct Neighbor
  * indirectly through busses
  *===========================================================================*/
 struct Bus {
+  //types ---------------------------------------------------------------------
+  //reactive limit a voltage controlling bus has been switched to PQ at
+  enum class QLimit{ None, Min, Max };
+
   //data ----------------------------------------------------------------------
   int               id{-1};                   //identification key
   double            rating;               //rating in kV
@@ -78,9 +181,19 @@ struct Bus {
   Generator         *generator{nullptr};  //attached generator
   Load              *load{nullptr};       //attached load
   int               jidx[2]{-1,-1};       //jacobean index information
+  QLimit            qlim{QLimit::None};   //reactive limit currently enforced
  
   //constructors --------------------------------------------------------------
   Bus(int id, double rating, complex shunt_y={0,0});
+
+  //methods -------------------------------------------------------------------
+  //true if the voltage magnitude of this bus is currently held by a generator
+  bool vControlled() const;
+
+  //true if this bus has a reactive power row and voltage magnitude column in
+  //the jacobean, this is the case for load buses and for generator buses that
+  //may switch to PQ when they hit a reactive limit
+  bool qRow() const;
 };
 
 /*=============================================================================
@@ -110,6 +223,8 @@ struct Branch {
   array<Bus*, 2>  b;        //the buses this branch interconnects
   array<int, 2>   bus_ids;  //the ids of the buses that this branch 
                             //interconnects
+  double          smax{0};  //thermal limit in per unit apparent power at
+                            //either end, zero if unlimited
   
   //constructors --------------------------------------------------------------
   Branch(Kind kind);
@@ -153,6 +268,25 @@ struct SimpleLine : public Line {
   complex cy() override;
 };
 
+/*=============================================================================
+ * A #ThreePhaseLine is a #Line with full phase coupling for unbalanced
+ * studies, its positive sequence values stand in for it in the balanced
+ * solvers
+ *===========================================================================*/
+struct ThreePhaseLine : public Line {
+  //data ----------------------------------------------------------------------
+  array<complex, 9> zabc,   //series impedance matrix, row major
+                    yabc;   //total shunt admittance matrix, row major
+
+  //constructors --------------------------------------------------------------
+  ThreePhaseLine(array<complex, 9> zabc, array<complex, 9> yabc);
+
+  //methods -------------------------------------------------------------------
+  //positive sequence impedance, mean self less mean mutual impedance
+  complex z() const override;
+  complex cy() override;
+};
+
 /*=============================================================================
  * A #Transformer is a type of #Branch, this is an abstract class.
  *===========================================================================*/
@@ -187,12 +321,30 @@ struct SimpleTransformer : public Transformer {
  * concrete generator classes must implement
  *===========================================================================*/
 struct Generator {
+  //types ---------------------------------------------------------------------
+  enum class Kind{ Static, Classical, FourthOrder };
+
   //data ----------------------------------------------------------------------
+  Kind      kind{Kind::Static}; //dynamic model of the generator
   int       id{-1},         //id of the generator
             bus_id{-1};     //id of the bus this generator is connected to
   Bus       *bus{nullptr};  //pointer to the attached bus
+  double    qmin{-std::numeric_limits<double>::infinity()},
+            qmax{std::numeric_limits<double>::infinity()};
+                            //reactive limits on the net injection at the
+                            //attached bus, per unit
+  complex   zsub{0,0};      //subtransient impedance, zero if unknown
+  double    c0{0}, c1{0}, c2{0};
+                            //production cost c0 + c1 P + c2 P^2 with P the
+                            //active output in per unit
+  double    pmin{0},
+            pmax{std::numeric_limits<double>::infinity()};
+                            //active output limits, per unit
 
   //methods -------------------------------------------------------------------
+  //true if either reactive limit is finite
+  bool qLimited() const;
+
   //returns the complex voltage at this bus, must be implemented by concrete
   //subclasses
   virtual complex v(double t) const = 0;
@@ -210,12 +362,82 @@ struct StaticGen : public Generator {
   complex v(double t) const override;
 };
 
+/*=============================================================================
+ * A #ClassicalGen is a constant voltage behind transient reactance machine
+ * for time domain simulation. In the power flow it holds the attached bus at
+ * its setpoint like a #StaticGen. Inertia is on the system base
+ *===========================================================================*/
+struct ClassicalGen : public Generator {
+  //data ----------------------------------------------------------------------
+  complex   _v;           //power flow voltage setpoint
+  double    H,            //inertia constant, seconds
+            D,            //damping, per unit power per unit speed
+            xdp;          //d axis transient reactance
+
+  //constructors --------------------------------------------------------------
+  ClassicalGen(complex v, double H, double D, double xdp);
+
+  //methods -------------------------------------------------------------------
+  complex v(double t) const override;
+};
+
+/*=============================================================================
+ * A #FourthOrderGen is a two axis machine with transient dynamics on both
+ * axes and constant field voltage and mechanical power
+ *===========================================================================*/
+struct FourthOrderGen : public ClassicalGen {
+  //data ----------------------------------------------------------------------
+  double    xd, xq,       //synchronous reactances
+            xqp,          //q axis transient reactance
+            Td0p, Tq0p;   //open circuit transient time constants, seconds
+
+  //constructors --------------------------------------------------------------
+  FourthOrderGen(complex v, double H, double D, double xd, double xq,
+                 double xdp, double xqp, double Td0p, double Tq0p);
+};
+
 /*=============================================================================
  * #Load is an abstract class that defines the interface that all
- * concrete Load classes must implement
+ * concrete Load classes must implement. Loads modeled here are voltage
+ * dependent and consume on top of the constant power schedule
  *===========================================================================*/
 struct Load {
+  //types ---------------------------------------------------------------------
+  enum class Kind{ ZIP, Exponential };
+
+  //data ----------------------------------------------------------------------
+  Kind      kind;           //what kind of load this is
+  int       id{-1},         //id of the load
+            bus_id{-1};     //id of the bus this load is connected to
+  Bus       *bus{nullptr};  //pointer to the attached bus
+  complex   s0;             //consumption at the nominal voltage, per unit
+  double    vn{1};          //nominal voltage magnitude, per unit
 
+  //constructors --------------------------------------------------------------
+  Load(Kind kind, complex s0);
+};
+
+/*=============================================================================
+ * A #ZipLoad is a mix of constant impedance, constant current and constant
+ * power consumption, the shares of each sum to one for P and for Q
+ *===========================================================================*/
+struct ZipLoad : public Load {
+  //data ----------------------------------------------------------------------
+  array<double, 3>  p, q;   //impedance, current and power shares
+
+  //constructors --------------------------------------------------------------
+  ZipLoad(complex s0, array<double, 3> p, array<double, 3> q);
+};
+
+/*=============================================================================
+ * An #ExponentialLoad consumes P0 (|V|/vn)^np and Q0 (|V|/vn)^nq
+ *===========================================================================*/
+struct ExponentialLoad : public Load {
+  //data ----------------------------------------------------------------------
+  double    np, nq;         //voltage exponents
+
+  //constructors --------------------------------------------------------------
+  ExponentialLoad(complex s0, double np, double nq);
 };
 
 
@@ -238,6 +460,60 @@ struct JacobiStructureInfo {
   std::string toString();
 };
 
+/*=============================================================================
+ * The kind of a bus as far as the power flow equations go. A PVQ bus is a
+ * reactive limited generator holding its voltage, it owns a reactive row
+ * which is held at the identity until the generator hits a limit and the bus
+ * becomes PQ
+ *===========================================================================*/
+enum class BusKind{ Slack, PV, PVQ, PQ };
+
+BusKind busKind(const Bus &b);
+
+/*=============================================================================
+ * #BusBlocks is an internal ordering of the buses of a #Jacobi that groups
+ * them into contiguous slack, PV, PVQ and PQ blocks, with the jacobian
+ * indices, the admittance and jacobian value slots of every bus and of each
+ * of its neighbors resolved up front. The kernels over one block are
+ * specialized on its kind and run as straight line loops. An entry that does
+ * not exist, a column of a slack neighbor say, points to a scratch slot of
+ * its bus past the end of the jacobian values in %w so it can be written
+ * without a test, and buses on different threads never share one
+ *===========================================================================*/
+struct BusBlocks {
+  //data ----------------------------------------------------------------------
+  vector<int>     order;            //buses, block by block
+  size_t          begin[5]{0,0,0,0,0}; //block of kind k is [begin[k],
+                                    //begin[k+1]) of %order
+  vector<int>     nbus,             //neighbor buses
+                  at;               //position of each bus in %order
+  vector<sindex>  j0, j1,           //jacobian indices, -1 if absent
+                  ydiag,            //slot of Y(i,i)
+                  d00, d01, d10, d11, //slots of the diagonal 2x2 in J
+                  nbeg,             //neighbors of order[k] are
+                                    //[nbeg[k], nbeg[k+1])
+                  ypos,             //slot of Y(i,j) of each neighbor
+                  o00, o01, o10, o11; //slots of the off diagonal 2x2 in J
+  vector<double>  w;                //jacobian values plus a scratch slot
+                                    //per bus
+
+  //methods -------------------------------------------------------------------
+  //groups the buses of @g by their current kind and resolves their slots in
+  //@y and @m
+  void build(Grid &g, SMatrix<complex> &y, SMatrix<double> &m);
+
+  size_t first(BusKind k) const { return begin[static_cast<int>(k)]; }
+  size_t last(BusKind k) const { return begin[static_cast<int>(k)+1]; }
+
+  //the kind of the bus at position @k of %order
+  BusKind kind(size_t k) const
+  {
+    int b{0};
+    while(k >= begin[b+1]) { ++b; }
+    return static_cast<BusKind>(b);
+  }
+};
+
 /*=============================================================================
  * The #Jacobi encapsulates the powerflow jacobean sparse matrix #SMatrix
  * object and the supporting information to make it functional
@@ -261,8 +537,21 @@ struct Jacobi {
                                             //combined into one vector used to
                                             //creat this jacobean
 
+  uint64_t                            topology{0}; //$topologyHash of %g
+
+  BusBlocks                           blocks; //buses grouped by kind, rebuilt
+                                            //by %regroup
+
+  int                                 threads{1}; //threads of the kernels
+                                            //over the bus blocks
+
+  LoadValues                          loads; //the loads of %g at %x
+
   //constructors --------------------------------------------------------------
-  Jacobi(Grid *g, SMatrix<complex> y, Glob<complex> x);
+  //the structure is restored from @cache when it holds this topology and is
+  //stored into it otherwise
+  Jacobi(Grid *g, SMatrix<complex> y, Glob<complex> x,
+         SymbolicCache *cache = nullptr);
 
   //methods -------------------------------------------------------------------
   //computes the structural information for this jacobean and stores in the
@@ -276,6 +565,14 @@ struct Jacobi {
   //update the jacobian based on the input information in the data member %x
   void update();
 
+  //updates only the rows of @buses, enough when no other voltage moved than
+  //those of @buses and of their neighbors
+  void update(const vector<int> &buses);
+
+  //regroups the buses after some of them changed kind, a reactive limited
+  //generator switching between PVQ and PQ
+  void regroup();
+
 };
 
 }
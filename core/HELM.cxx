@@ -0,0 +1,255 @@
+#include "HELM.hxx"
+#include <algorithm>
+#include <cmath>
+
+using namespace gridworks;
+using std::vector;
+using std::runtime_error;
+using std::to_string;
+
+HELM::HELM(Grid *g, Glob<complex> vset, Glob<complex> sSch)
+  : G{g}, vset{vset}, sSch{sSch}, state(g->buses.size())
+{
+  if(!g->loads.empty()) {
+    throw runtime_error("HELM does not model voltage dependent loads");
+  }
+
+  Y = ymatrix(*g).canonical();
+  sindex nb = Y.n;
+
+  //the series part of each row sums to zero, the remainder is the shunt
+  ysh.assign(nb, complex{0,0});
+  for(sindex i=0; i<nb; ++i) {
+    for(sindex k=Y.r[i]; k<Y.r[i+1]; ++k) { ysh[i] += Y.v[k]; }
+  }
+
+  pos.assign(nb, -1);
+  sindex np{0};
+  bool slack{false};
+  for(sindex i=0; i<nb; ++i)
+  {
+    if(g->buses[i]->slack) { slack = true; continue; }
+    pos[i] = np++;
+  }
+  if(!slack) { throw runtime_error("HELM needs a slack bus"); }
+
+  //two rows per non slack bus, real and imaginary part of its current
+  //balance, against the unknown pair of every non slack neighbor
+  vector<sindex> ar{0}, ac;
+  vector<double> av;
+  for(sindex i=0; i<nb; ++i)
+  {
+    if(pos[i] < 0) { continue; }
+    for(int h=0; h<2; ++h)
+    {
+      for(sindex k=Y.r[i]; k<Y.r[i+1]; ++k)
+      {
+        sindex j = Y.c[k];
+        if(pos[j] < 0) { continue; }
+        complex y = Y.v[k] - (j == i ? ysh[i] : 0.0);
+        double first = pv(j) ? (h == 1 && j == i ? 1.0 : 0.0)
+                             : (h == 0 ? y.real() : y.imag());
+        ac.push_back(2*pos[j]);
+        av.push_back(first);
+        ac.push_back(2*pos[j]+1);
+        av.push_back(h == 0 ? -y.imag() : y.real());
+      }
+      ar.push_back(ac.size());
+    }
+  }
+  A = SMatrix<double>(2*np, ac.size());
+  std::copy(ar.begin(), ar.end(), A.r);
+  std::copy(ac.begin(), ac.end(), A.c);
+  std::copy(av.begin(), av.end(), A.v);
+
+  mkl_err = dss_create(mkl_handle, dss_opt);
+  if(mkl_err != MKL_DSS_SUCCESS) { mkl_death(); }
+
+  mkl_err = dss_define_structure(
+      mkl_handle, dss_struct_opt, A.r, A.n, A.n, A.c, A.s);
+  if(mkl_err != MKL_DSS_SUCCESS) { mkl_death(); }
+
+  mkl_err = dss_reorder(mkl_handle, dss_reorder_opt, 0);
+  if(mkl_err != MKL_DSS_SUCCESS) { mkl_death(); }
+
+  mkl_err = dss_factor_real(mkl_handle, dss_factor_opt, A.v);
+  if(mkl_err != MKL_DSS_SUCCESS) {
+    throw runtime_error("HELM matrix is singular, is the grid islanded?");
+  }
+
+  rhs.assign(A.n, 0);
+  x.assign(A.n, 0);
+}
+
+HELM::~HELM()
+{
+  dss_delete(mkl_handle, dss_solve_opt);
+}
+
+void HELM::mkl_death()
+{
+  throw runtime_error{
+    "MKL has exploded with error: " + to_string(mkl_err)
+  };
+}
+
+bool HELM::pv(int bus) const
+{
+  const Bus &b = *G->buses[bus];
+  return !b.slack && b.vControlled();
+}
+
+void HELM::coefficients(int n)
+{
+  size_t nb = Y.n;
+  complex *Vn = &V[n*nb];
+  const complex *Vp = &V[(n-1)*nb],
+                *Wp = &W[(n-1)*nb];
+
+  //known coefficients, slack voltages and the real part of PV voltages from
+  //the magnitude constraint
+  for(size_t i=0; i<nb; ++i)
+  {
+    if(pos[i] < 0) {
+      Vn[i] = n == 1 ? vset.data[i] - 1.0 : complex{0,0};
+    }
+    else if(pv(i))
+    {
+      double vr = n == 1 ? std::norm(vset.data[i]) - 1.0 : 0.0;
+      for(int m=1; m<n; ++m) {
+        vr -= (V[m*nb+i] * std::conj(V[(n-m)*nb+i])).real();
+      }
+      Vn[i] = 0.5 * vr;
+    }
+  }
+
+  for(size_t i=0; i<nb; ++i)
+  {
+    if(pos[i] < 0) { continue; }
+    complex c = -ysh[i] * Vp[i];
+    if(pv(i))
+    {
+      c += sSch.data[i].real() * std::conj(Wp[i]);
+      for(int m=1; m<n; ++m) {
+        c -= complex{0, Q[m*nb+i]} * std::conj(W[(n-m)*nb+i]);
+      }
+    }
+    else { c += std::conj(sSch.data[i]) * std::conj(Wp[i]); }
+
+    for(sindex k=Y.r[i]; k<Y.r[i+1]; ++k)
+    {
+      sindex j = Y.c[k];
+      complex y = Y.v[k] - (j == (sindex)i ? ysh[i] : 0.0);
+      if(pos[j] < 0) { c -= y * Vn[j]; }
+      else if(pv(j)) { c -= y * Vn[j].real(); }
+    }
+    rhs[2*pos[i]] = c.real();
+    rhs[2*pos[i]+1] = c.imag();
+  }
+
+  _INTEGER_t nrhs{1};
+  mkl_err =
+    dss_solve_real(mkl_handle, dss_solve_opt, rhs.data(), nrhs, x.data());
+  if(mkl_err != MKL_DSS_SUCCESS) { mkl_death(); }
+
+  for(size_t i=0; i<nb; ++i)
+  {
+    if(pos[i] < 0) { continue; }
+    sindex p = 2*pos[i];
+    if(pv(i))
+    {
+      Q[n*nb+i] = x[p];
+      Vn[i] = {Vn[i].real(), x[p+1]};
+    }
+    else { Vn[i] = {x[p], x[p+1]}; }
+  }
+
+  //W = 1/V, convolution with V[0] = 1
+  for(size_t i=0; i<nb; ++i)
+  {
+    complex w{0,0};
+    for(int m=0; m<n; ++m) { w -= W[m*nb+i] * V[(n-m)*nb+i]; }
+    W[n*nb+i] = w;
+  }
+}
+
+complex HELM::pade(int bus, int n) const
+{
+  size_t nb = Y.n;
+  vector<complex> a(n+1, complex{0,0}), b(n);
+  complex sum{0,0};
+  for(int j=0; j<n; ++j)
+  {
+    sum += V[j*nb+bus];
+    b[j] = sum;
+  }
+
+  //a holds column k-1 and b column k of the epsilon table over the partial
+  //sums, the even columns are the diagonal Pade approximants
+  complex best = b[n-1];
+  for(int k=0, len=n; len>1; ++k, --len)
+  {
+    for(int j=0; j<len-1; ++j)
+    {
+      complex d = b[j+1] - b[j];
+      if(std::abs(d) <= 1e-15 * std::abs(b[j+1])) { return best; }
+      a[j] = a[j+1] + 1.0 / d;
+    }
+    std::swap(a, b);
+    if(k % 2 == 1) { best = b[len-2]; }
+  }
+  return best;
+}
+
+bool HELM::run()
+{
+  size_t nb = Y.n;
+  V.assign((max_order+1)*nb, complex{0,0});
+  W.assign((max_order+1)*nb, complex{0,0});
+  Q.assign((max_order+1)*nb, 0.0);
+  std::fill(V.begin(), V.begin()+nb, complex{1,0});
+  std::fill(W.begin(), W.begin()+nb, complex{1,0});
+  for(size_t i=0; i<nb; ++i) { state.data[i] = {1,0}; }
+
+  solved = false;
+  bool converged{false};
+  vector<complex> est(nb);
+  for(order=1; order<=max_order; ++order)
+  {
+    coefficients(order);
+
+    //diagonal approximants need an odd number of coefficients
+    if(order % 2 == 1) { continue; }
+
+    double d{0};
+    bool finite{true};
+    #pragma omp parallel for reduction(max:d) reduction(&&:finite)
+    for(size_t i=0; i<nb; ++i)
+    {
+      est[i] = pade(i, order+1);
+      finite = finite && std::isfinite(est[i].real())
+                      && std::isfinite(est[i].imag());
+      d = std::max(d, std::abs(est[i] - state.data[i]));
+    }
+    if(!finite) { break; }
+    std::copy(est.begin(), est.end(), state.data);
+    if(order > 2 && d < tol) { converged = true; break; }
+  }
+  order = std::min(order, max_order);
+
+  //a converged continuation must also satisfy the schedule
+  sCalc = G->sCalc(state, Y);
+  mismatch = 0;
+  for(size_t i=0; i<nb; ++i)
+  {
+    if(pos[i] < 0) { continue; }
+    complex ds = sCalc.data[i] - sSch.data[i];
+    double e = pv(i) ? std::max(std::abs(ds.real()),
+                          std::abs(std::abs(state.data[i]) -
+                                   std::abs(vset.data[i])))
+                     : std::abs(ds);
+    mismatch = std::max(mismatch, e);
+  }
+  solved = converged && mismatch < mismatch_tol;
+  return solved;
+}
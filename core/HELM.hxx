@@ -0,0 +1,91 @@
+#ifndef GW_HELM
+#define GW_HELM
+
+#include "Grid.hxx"
+#include <mkl_dss.h>
+#include <stdexcept>
+#include <string>
+
+namespace gridworks {
+
+/*=============================================================================
+ * The #HELM engine solves the power flow with the holomorphic embedding
+ * method. The admittance matrix is split into its series part Ytr, whose
+ * rows sum to zero, and the bus shunts Ysh, and the bus voltages are
+ * embedded as power series V(s) such that
+ *
+ *   PQ    : sum Ytr V(s) = s S* / V*(s*) - s Ysh V(s)
+ *   PV    : sum Ytr V(s) = (s P - j Q(s)) / V*(s*) - s Ysh V(s)
+ *           V(s) V*(s*)  = 1 + s (|Vsp|^2 - 1)
+ *   slack : V(s)         = 1 + s (Vsp - 1)
+ *
+ * which is the all ones germ at s = 0 and the power flow at s = 1. Every
+ * series coefficient comes from one solve against a real matrix with fixed
+ * values, unknowns (Re V, Im V) at PQ buses and (Q, Im V) at PV buses, so the
+ * matrix is factored once. The series is summed at s = 1 with diagonal Pade
+ * approximants through the Wynn epsilon algorithm.
+ *
+ * There is no initial guess. When the Pade approximants do not converge
+ * within %max_order coefficients, or converge to voltages that do not meet
+ * the schedule, the case has no solution on the stable branch. Generator
+ * reactive limits are not enforced, and a grid with voltage dependent loads
+ * (Grid::loads) is refused since the embedding only holds constant power
+ *===========================================================================*/
+struct HELM {
+  //data ----------------------------------------------------------------------
+  Grid              *G;
+  SMatrix<complex>  Y{0,0};           //admittance matrix, canonical
+  SMatrix<double>   A{0,0};           //real coefficient matrix
+  Glob<complex>     vset, sSch;       //voltage setpoints, scheduled power
+  Glob<complex>     state, sCalc;     //solution and its injections
+  vector<complex>   ysh;              //shunt admittance of each bus
+  vector<int>       pos;              //unknown pair of each bus, -1 slack
+  vector<complex>   V, W;             //coefficients, order major
+  vector<double>    Q;                //PV reactive coefficients, order major
+  vector<double>    rhs, x;
+
+  int               max_order{60},    //longest series tried
+                    order{0};         //coefficients computed by run
+  double            tol{1e-9},        //Pade convergence on the voltages
+                    mismatch_tol{1e-6},
+                    mismatch{0};      //worst schedule mismatch of state
+  bool              solved{false};
+
+  _MKL_DSS_HANDLE_t mkl_handle;
+  _INTEGER_t mkl_err{ MKL_DSS_SUCCESS };
+  _INTEGER_t
+    dss_opt{ MKL_DSS_MSG_LVL_WARNING +
+             MKL_DSS_TERM_LVL_ERROR +
+             MKL_DSS_ZERO_BASED_INDEXING
+           },
+    dss_struct_opt{ MKL_DSS_NON_SYMMETRIC },
+    dss_reorder_opt{ MKL_DSS_AUTO_ORDER },
+    dss_factor_opt{ MKL_DSS_INDEFINITE },
+    dss_solve_opt{ MKL_DSS_DEFAULTS };
+
+  //constructors --------------------------------------------------------------
+  //@vset supplies the slack voltage and the PV magnitudes (see
+  //Grid::flatStart), @sSch the scheduled injection of every bus
+  HELM(Grid *g, Glob<complex> vset, Glob<complex> sSch);
+  ~HELM();
+  HELM(const HELM &) = delete;
+  HELM & operator=(const HELM &) = delete;
+
+  //methods -------------------------------------------------------------------
+  //computes the series until the Pade approximants settle, the solution is
+  //left in state, returns false if the case has no solution
+  bool run();
+
+  //computes the coefficients of order @n from those below it
+  void coefficients(int n);
+
+  //Pade estimate of the voltage of @bus from the first @n coefficients
+  complex pade(int bus, int n) const;
+
+  bool pv(int bus) const;
+  void mkl_death();
+};
+
+}
+
+#endif
@@ -4,7 +4,7 @@ using namespace gridworks;
 using namespace gridworks::ip;
 using std::string;
 using std::stringstream;
-using std::endl;
+using std::ostream;
 using std::to_string;
 using std::min;
 using std::max;
@@ -12,111 +12,124 @@ using std::max;
 string Network::topDL() const
 {
   stringstream ss;
-  ss << "<experiment>" << endl;
-  ss << "<version>1.0</version>" << endl << endl;
+  topDL(ss);
+  return ss.str();
+}
+
+void Network::topDL(ostream &out) const
+{
+  out << "<experiment>\n";
+  out << "<version>1.0</version>\n\n";
  
   //lcl-rmt substrate
-  ss << "<substrates>" << endl;
-  ss << "<name>lcl-dtr</name>" << endl;
+  out << "<substrates>\n";
+  out << "<name>lcl-dtr</name>\n";
 
-  ss << "<capacity>" << endl;
-  ss << "<rate>" << 1000 << "</rate>" << endl;
-  ss << "<kind>max</kind>" << endl;
-  ss << "</capacity>" << endl;
+  out << "<capacity>\n";
+  out << "<rate>" << 1000 << "</rate>\n";
+  out << "<kind>max</kind>\n";
+  out << "</capacity>\n";
   
-  ss << "<latency>" << endl;
-  ss << "<time>" << 0 << "</time>" << endl;
-  ss << "<kind>average</kind>" << endl;
-  ss << "</latency>" << endl;
-  ss << "</substrates>" << endl << endl;
+  out << "<latency>\n";
+  out << "<time>" << 0 << "</time>\n";
+  out << "<kind>average</kind>\n";
+  out << "</latency>\n";
+  out << "</substrates>\n\n";
 
   //lcl
-  ss << "<elements>" << endl;
-  ss << "<computer>" << endl;
-
-  ss << "<name>lcl</name>" << endl;
-  ss << "<interface>" << endl;
-  ss << "<substrate>lcl-dtr</substrate>" << endl;
-  ss << "<name>" << "inf" << 0 << "</name>" << endl;
-  ss << "</interface>" << endl;
-  ss << "<attribute>" << endl;
-  ss << "<attribute>testbed</attribute><value>deter</value>" << endl;
-  ss << "</attribute>" << endl << endl;
+  out << "<elements>\n";
+  out << "<computer>\n";
+
+  out << "<name>lcl</name>\n";
+  out << "<interface>\n";
+  out << "<substrate>lcl-dtr</substrate>\n";
+  out << "<name>" << "inf" << 0 << "</name>\n";
+  out << "</interface>\n";
+  out << "<attribute>\n";
+  out << "<attribute>testbed</attribute><value>deter</value>\n";
+  out << "</attribute>\n\n";
   
-  ss << "</computer>" << endl;
-  ss << "</elements>" << endl;
+  out << "</computer>\n";
+  out << "</elements>\n";
   
   //rmt
-  ss << "<elements>" << endl;
-  ss << "<computer>" << endl;
-
-  ss << "<name>rmt</name>" << endl;
-  ss << "<interface>" << endl;
-  ss << "<substrate>lcl-dtr</substrate>" << endl;
-  ss << "<name>" << "inf" << 0 << "</name>" << endl;
-  ss << "</interface>" << endl;
-  ss << "<attribute>" << endl;
-  ss << "<attribute>testbed</attribute><value>local</value>" << endl;
-  ss << "</attribute>" << endl << endl;
-
-  ss << "</computer>" << endl;
-  ss << "</elements>" << endl;
-
-  for(const Link *l : links) { ss << l->topDL() << endl; }
-  for(const Host *h : hosts) { ss << h->topDL() << endl; }
+  out << "<elements>\n";
+  out << "<computer>\n";
+
+  out << "<name>rmt</name>\n";
+  out << "<interface>\n";
+  out << "<substrate>lcl-dtr</substrate>\n";
+  out << "<name>" << "inf" << 0 << "</name>\n";
+  out << "</interface>\n";
+  out << "<attribute>\n";
+  out << "<attribute>testbed</attribute><value>local</value>\n";
+  out << "</attribute>\n\n";
+
+  out << "</computer>\n";
+  out << "</elements>\n";
+
+  for(const Link *l : links) { l->topDL(out); out << '\n'; }
+  for(const Host *h : hosts) { h->topDL(out); out << '\n'; }
   
-  ss << "</experiment>" << endl;
-  return ss.str();
+  out << "</experiment>\n";
 }
 
 string Host::topDL() const
 {
   stringstream ss;
-  ss << "<elements>" << endl;
-  ss << "<computer>" << endl;
+  topDL(ss);
+  return ss.str();
+}
 
-  ss << "<name>h" << id << "</name>" << endl;
+void Host::topDL(ostream &out) const
+{
+  out << "<elements>\n";
+  out << "<computer>\n";
+
+  out << "<name>h" << id << "</name>\n";
   size_t inf{0};
   for(const Neighbor &nbr : neighbors) {
-    ss << "<interface>" << endl;
-    ss << "<substrate>" 
-       << "s" << min(id, nbr.h->id) << "-" <<  max(id, nbr.h->id) 
-       <<"</substrate>" << endl;
-    ss << "<name>" << "inf" << inf << "</name>" << endl;
-    ss << "</interface>" << endl;
-    ss << "<attribute>" << endl;
-    ss << "<attribute>testbed</attribute><value>deter</value>" << endl;
-    ss << "</attribute>" 
-       << endl;
+    out << "<interface>\n";
+    out << "<substrate>" 
+        << "s" << min(id, nbr.h->id) << "-" <<  max(id, nbr.h->id) 
+        << "</substrate>\n";
+    out << "<name>" << "inf" << inf++ << "</name>\n";
+    out << "</interface>\n";
+    out << "<attribute>\n";
+    out << "<attribute>testbed</attribute><value>deter</value>\n";
+    out << "</attribute>\n";
   }
 
-  ss << "</computer>" << endl;
-  ss << "</elements>" << endl;
-  return ss.str();
+  out << "</computer>\n";
+  out << "</elements>\n";
 }
 
 string Link::topDL() const
 {
   stringstream ss;
+  topDL(ss);
+  return ss.str();
+}
+
+void Link::topDL(ostream &out) const
+{
   size_t sa = endpoints[0]->id, sb = endpoints[1]->id;
-  ss << "<substrates>" << endl;
-  ss << "<name>s" 
-     << min(sa,sb) << "-" << max(sa,sb) << "</name>" 
-     << endl;
-
-  ss << "<capacity>" << endl;
-  ss << "<rate>" << capacity << "</rate>" << endl;
-  ss << "<kind>max</kind>" << endl;
-  ss << "</capacity>" << endl;
+  out << "<substrates>\n";
+  out << "<name>s" 
+      << min(sa,sb) << "-" << max(sa,sb) << "</name>\n";
+
+  out << "<capacity>\n";
+  out << "<rate>" << capacity << "</rate>\n";
+  out << "<kind>max</kind>\n";
+  out << "</capacity>\n";
   
-  ss << "<latency>" << endl;
-  ss << "<time>" << latency << "</time>" << endl;
-  ss << "<kind>average</kind>" << endl;
-  ss << "</latency>" << endl;
+  out << "<latency>\n";
+  out << "<time>" << latency << "</time>\n";
+  out << "<kind>average</kind>\n";
+  out << "</latency>\n";
 
 
-  ss << "</substrates>" << endl;
-  return ss.str();
+  out << "</substrates>\n";
 }
 
 Host::Host(size_t id) : id{id} {}
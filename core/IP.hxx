@@ -4,6 +4,7 @@
 #include <string>
 #include <vector>
 #include <sstream>
+#include <ostream>
 
 namespace gridworks { namespace ip {
 
@@ -15,6 +16,7 @@ struct Network {
   std::vector<Host*> hosts;
   std::vector<Link*> links;
   std::string topDL() const;
+  void topDL(std::ostream &out) const;
 };
 
 struct Neighbor {
@@ -28,6 +30,7 @@ struct Host {
   size_t id;
   std::vector<Neighbor> neighbors;
   std::string topDL() const;
+  void topDL(std::ostream &out) const;
 };
 
 struct Link {
@@ -35,6 +38,7 @@ struct Link {
   double capacity, latency;
   Host *endpoints[2] = {nullptr, nullptr};
   std::string topDL() const;
+  void topDL(std::ostream &out) const;
 };
 
 void connect(Host *a, Link *l, Host *b);
@@ -0,0 +1,94 @@
+#include "IPMapping.hxx"
+#include <algorithm>
+#include <unordered_map>
+
+using namespace gridworks;
+using namespace gridworks::ip;
+using std::vector;
+
+LinkRule::LinkRule(double capacity, double latency, double per_z)
+  : capacity{capacity}, latency{latency}, per_z{per_z} {}
+
+static int findRoot(vector<int> &up, int i)
+{
+  while(up[i] != i)
+  {
+    up[i] = up[up[i]];
+    i = up[i];
+  }
+  return i;
+}
+
+GridNetwork ip::fromGrid(const Grid &grid, const MappingRules &rules)
+{
+  GridNetwork gn;
+  size_t nb = grid.buses.size();
+
+  //substations are the buses connected by transformers
+  vector<int> up(nb);
+  for(size_t i=0; i<nb; ++i) { up[i] = i; }
+  if(rules.scope == MappingRules::Scope::Substation)
+  {
+    for(const Transformer *t : grid.transformers)
+    {
+      int a = findRoot(up, t->b[0]->id), b = findRoot(up, t->b[1]->id);
+      if(a != b) { up[std::max(a, b)] = std::min(a, b); }
+    }
+  }
+
+  //hosts numbered in the order of their first bus
+  gn.host.resize(nb);
+  vector<int> of(nb, -1);
+  for(size_t i=0; i<nb; ++i)
+  {
+    int r = findRoot(up, i);
+    if(of[r] < 0)
+    {
+      of[r] = gn.network.hosts.size();
+      gn.network.hosts.push_back(new Host(of[r]));
+    }
+    gn.host[i] = of[r];
+  }
+
+  std::unordered_map<uint64_t, Link*> between;
+  auto link = [&](uint32_t a, uint32_t b, double capacity, double latency)
+  {
+    if(a == b) { return; }
+    uint64_t key = (uint64_t{std::min(a, b)} << 32) | std::max(a, b);
+    auto l = between.find(key);
+    if(l != between.end())
+    {
+      l->second->capacity += capacity;
+      l->second->latency = std::min(l->second->latency, latency);
+      return;
+    }
+    Link *k = new Link(capacity, latency);
+    connect(gn.network.hosts[a], k, gn.network.hosts[b]);
+    gn.network.links.push_back(k);
+    between[key] = k;
+  };
+
+  auto branch = [&](const Branch &br, const LinkRule &base)
+  {
+    LinkRule r = base;
+    if(rules.branch) { rules.branch(br, r); }
+    if(!r.enabled) { return; }
+    link(gn.host[br.b[0]->id], gn.host[br.b[1]->id], r.capacity,
+         r.latency + r.per_z * std::abs(br.z()));
+  };
+  for(const Line *l : grid.lines) { branch(*l, rules.line); }
+  for(const Transformer *t : grid.transformers) {
+    branch(*t, rules.transformer);
+  }
+
+  if(rules.center)
+  {
+    uint32_t nh = gn.network.hosts.size();
+    gn.center = nh;
+    gn.network.hosts.push_back(new Host(nh));
+    const LinkRule &r = rules.center_link;
+    for(uint32_t h=0; h<nh; ++h) { link(h, nh, r.capacity, r.latency); }
+  }
+
+  return gn;
+}
@@ -0,0 +1,70 @@
+#ifndef GW_IPMAPPING
+#define GW_IPMAPPING
+
+#include "Grid.hxx"
+#include "IP.hxx"
+#include <cstdint>
+#include <functional>
+
+namespace gridworks { namespace ip {
+
+/*=============================================================================
+ * A #LinkRule gives the communication link laid along a branch, capacity in
+ * Mbit/s and latency in milliseconds as in the topDL model. The latency is
+ * %latency plus %per_z times the impedance magnitude of the branch in per
+ * unit, a stand in for its length
+ *===========================================================================*/
+struct LinkRule {
+  //data ----------------------------------------------------------------------
+  double  capacity{100},
+          latency{0},
+          per_z{250};
+  bool    enabled{true};
+
+  //constructors --------------------------------------------------------------
+  LinkRule() = default;
+  LinkRule(double capacity, double latency, double per_z = 0);
+};
+
+/*=============================================================================
+ * The #MappingRules say how $fromGrid derives a network from a grid. With
+ * the Substation scope the buses joined by transformers share one host,
+ * with the Bus scope every bus gets its own. The %branch hook sees the rule
+ * of every branch before it is applied and may change or disable it. A
+ * control centre host linked to every other host is added on request
+ *===========================================================================*/
+struct MappingRules {
+  //types ---------------------------------------------------------------------
+  enum class Scope { Bus, Substation };
+
+  //data ----------------------------------------------------------------------
+  Scope     scope{Scope::Substation};
+  LinkRule  line, transformer;
+  std::function<void(const Branch&, LinkRule&)> branch;
+  bool      center{false};
+  LinkRule  center_link{1000, 10};
+};
+
+/*=============================================================================
+ * A #GridNetwork is the network derived from a grid and the host serving
+ * each of its buses, both index into %network.hosts. The hosts and links
+ * are allocated with new and, as for any ip::%Network, owned by the caller
+ *===========================================================================*/
+struct GridNetwork {
+  //data ----------------------------------------------------------------------
+  Network                 network;
+  std::vector<uint32_t>   host;     //host of each bus
+  int                     center{-1};
+};
+
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * The $fromGrid function derives the communication network of a @grid
+ * following the @rules. Branches between buses of one host carry no link
+ * and parallel branches between two hosts share one link, with their
+ * capacities added up and the lowest latency
+ *~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~*/
+GridNetwork fromGrid(const Grid &grid, const MappingRules &rules = {});
+
+}}
+
+#endif
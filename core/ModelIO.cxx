@@ -1,4 +1,7 @@
 #include "ModelIO.hxx"
+#include <exception>
+#include <limits>
+#include <new>
 
 using namespace gridworks;
 using namespace cypress;
@@ -22,6 +25,33 @@ cypress::gridFromJson(string filename) {
   string src = readFile(filename);
 
   BSONObj bsob = fromjson(src);
+  return gridFromBson(bsob.objdata(), bsob.objsize());
+
+}
+
+//the document at the start of the @size bytes at @data, which must lie
+//wholly within them and be well formed down to its nested elements
+static BSONObj
+snapshot(const char *data, size_t size) {
+
+  if(size < 4) {
+    throw runtime_error("the supplied snapshot is too short to be a document");
+  }
+  BSONObj bsob(data);
+  if(bsob.objsize() < 5 || size_t(bsob.objsize()) > size) {
+    throw runtime_error("the supplied snapshot is truncated");
+  }
+  if(!bsob.valid()) {
+    throw runtime_error("the supplied snapshot is corrupt");
+  }
+  return bsob;
+
+}
+
+Grid
+cypress::gridFromBson(const char *data, size_t size) {
+
+  BSONObj bsob = snapshot(data, size);
   BSONElement grid_elem = bsob["grid"];
   if(grid_elem.eoo()) {
     throw runtime_error("the supplied grid object does not contain a grid");
@@ -37,6 +67,10 @@ cypress::gridFromJson(string filename) {
   grid.shunt_caps = getShuntCapacitors(grid_bse);
   resolveShuntCaps(grid);
 
+  grid.loads = getLoads(grid_bse);
+  resolveLoads(grid);
+  grid.gatherLoads();
+
   grid.lines = getLines(grid_bse);
   resolveBranches(grid.lines, grid.buses);
 
@@ -47,6 +81,275 @@ cypress::gridFromJson(string filename) {
 
 }
 
+//Parallel loading ------------------------------------------------------------
+
+//the sections of a model in the order the sequential loader builds them
+enum Section { Buses, Generators, ShuntCaps, Loads, Lines, Transformers,
+               NumSections };
+
+//the error of the earliest element that failed in each section
+struct SectionErrors {
+  std::exception_ptr  err[NumSections];
+  size_t              at[NumSections];
+
+  SectionErrors()
+  {
+    std::fill(at, at + NumSections, std::numeric_limits<size_t>::max());
+  }
+
+  void fail(Section s, size_t i)
+  {
+    #pragma omp critical(gw_model_errors)
+    if(i < at[s]) { at[s] = i; err[s] = std::current_exception(); }
+  }
+
+  void rethrow() const
+  {
+    for(const std::exception_ptr &e : err) {
+      if(e) { std::rethrow_exception(e); }
+    }
+  }
+};
+
+//spawns the tasks that build out[i] = make(elems[i], i) for one section in
+//chunks, @out must outlive the tasks
+template <class T, class F>
+static void buildSection(Section s, const vector<BSONElement> &elems,
+                         vector<T> &out, F make, SectionErrors *errors)
+{
+  const size_t chunk{1024};
+  size_t n = elems.size();
+  out.resize(n);
+  const BSONElement *in = elems.data();
+  T *o = out.data();
+  for(size_t b=0; b<n; b+=chunk) {
+    #pragma omp task firstprivate(s, b, n, in, o, make, errors)
+    {
+      size_t e = std::min(n, b + chunk), i = b;
+      try {
+        for(; i<e; ++i) { o[i] = make(in[i].Obj(), i); }
+      }
+      catch(...) { errors->fail(s, i); }
+    }
+  }
+}
+
+Grid
+cypress::gridFromJsonParallel(string filename, vector<string> *log) {
+
+  string src = readFile(filename);
+
+  BSONObj bsob = fromjson(src);
+  return gridFromBsonParallel(bsob.objdata(), bsob.objsize(), log);
+
+}
+
+Grid
+cypress::gridFromBsonParallel(const char *data, size_t size,
+                              vector<string> *log) {
+
+  BSONObj bsob = snapshot(data, size);
+  BSONElement grid_elem = bsob["grid"];
+  if(grid_elem.eoo()) {
+    throw runtime_error("the supplied grid object does not contain a grid");
+  }
+  BSONObj grid_bse = grid_elem.Obj();
+
+  //the element arrays, the sections themselves are independent
+  BSONElement buses_bson = grid_bse["buses"];
+  if(buses_bson.eoo()) {
+    throw runtime_error("the supplied grid object does not contain buses");
+  }
+  vector<BSONElement> bus_elems = buses_bson.Array(),
+                      gen_elems = getRequiredArray(grid_bse, "generators"),
+                      cap_elems = 
+                        getRequiredArray(grid_bse, "shunt_capacitors"),
+                      load_elems,
+                      line_elems = getRequiredArray(grid_bse, "lines"),
+                      tfmr_elems = getRequiredArray(grid_bse, "transformers");
+  bool has_loads = !grid_bse["loads"].eoo();
+  if(has_loads) { load_elems = getRequiredArray(grid_bse, "loads"); }
+
+  //buses live in one contiguous block, like the separately allocated
+  //components the grid never frees them
+  size_t nb = bus_elems.size();
+  Bus *block = static_cast<Bus*>(::operator new(nb * sizeof(Bus)));
+
+  Grid grid;
+  vector<Generator*> gens;
+  SectionErrors errors;
+
+  #pragma omp parallel
+  #pragma omp single
+  {
+    buildSection(Buses, bus_elems, grid.buses,
+        [block](const BSONObj &bo, size_t i) {
+          return new (block + i) Bus(getBus(bo));
+        }, &errors);
+    buildSection(Generators, gen_elems, gens,
+        [](const BSONObj &bo, size_t) { return getGenerator(bo); },
+        &errors);
+    buildSection(ShuntCaps, cap_elems, grid.shunt_caps,
+        [](const BSONObj &bo, size_t) { return getShuntCapacitor(bo); },
+        &errors);
+    buildSection(Loads, load_elems, grid.loads,
+        [](const BSONObj &bo, size_t) { return getLoad(bo); }, &errors);
+    buildSection(Lines, line_elems, grid.lines,
+        [](const BSONObj &bo, size_t) { return getLine(bo); }, &errors);
+    buildSection(Transformers, tfmr_elems, grid.transformers,
+        [](const BSONObj &bo, size_t) { return getTransformer(bo); },
+        &errors);
+  }
+  errors.rethrow();
+
+  //models that are not loaded leave no generator
+  for(Generator *g : gens) { if(g) { grid.generators.push_back(g); } }
+
+  //bus lookup by id, the first bus of an id wins as with find_if
+  vector<std::pair<int, Bus*>> by_id(nb);
+  #pragma omp parallel for
+  for(size_t i=0; i<nb; ++i) { by_id[i] = {block[i].id, block + i}; }
+  std::stable_sort(by_id.begin(), by_id.end(),
+      [](const std::pair<int, Bus*> &a, const std::pair<int, Bus*> &b) {
+        return a.first < b.first;
+      });
+  auto findBus = [&by_id](int id) -> Bus* {
+    auto b = std::lower_bound(by_id.begin(), by_id.end(), id,
+        [](const std::pair<int, Bus*> &x, int id) { return x.first < id; });
+    return b != by_id.end() && b->first == id ? b->second : nullptr;
+  };
+
+  //the lookups run in parallel, attaching to the buses stays in element
+  //order so that the last of several components on a bus wins as before
+  long ng = grid.generators.size();
+  #pragma omp parallel for
+  for(long k=0; k<ng; ++k) {
+    Generator *gen = grid.generators[k];
+    gen->bus = findBus(gen->bus_id);
+  }
+  for(Generator *gen : grid.generators) {
+    if(!gen->bus) {
+      throw runtime_error(
+          "generator " + to_string(gen->id) +
+          " references " + to_string(gen->bus_id) +
+          " which does not exist");
+    }
+    gen->bus->generator = gen;
+  }
+
+  long nc = grid.shunt_caps.size();
+  vector<Bus*> cap_bus(nc);
+  #pragma omp parallel for
+  for(long k=0; k<nc; ++k) {
+    cap_bus[k] = findBus(grid.shunt_caps[k]->bus_id);
+  }
+  for(long k=0; k<nc; ++k) {
+    const ShuntCap *sc = grid.shunt_caps[k];
+    if(!cap_bus[k]) {
+      throw runtime_error(
+          "Shunt Capacitor with id " + to_string(sc->id) +
+          " references bus " + to_string(sc->bus_id) +
+          " which does not exist");
+    }
+    cap_bus[k]->shunt_y = sc->y;
+  }
+
+  long nl = grid.loads.size();
+  #pragma omp parallel for
+  for(long k=0; k<nl; ++k) {
+    grid.loads[k]->bus = findBus(grid.loads[k]->bus_id);
+  }
+  for(Load *l : grid.loads) {
+    if(!l->bus) {
+      throw runtime_error(
+          "load " + to_string(l->id) +
+          " references " + to_string(l->bus_id) +
+          " which does not exist");
+    }
+    l->bus->load = l;
+  }
+  grid.gatherLoads();
+
+  //branches, lines first, see resolveBranches
+  vector<Branch*> brs(grid.lines.begin(), grid.lines.end());
+  brs.insert(brs.end(), grid.transformers.begin(), grid.transformers.end());
+  long nbr = brs.size();
+  #pragma omp parallel for
+  for(long k=0; k<nbr; ++k) {
+    Branch *br = brs[k];
+    br->b[0] = findBus(br->bus_ids[0]);
+    br->b[1] = findBus(br->bus_ids[1]);
+  }
+  for(const Branch *br : brs) {
+    for(size_t e=0; e<2; ++e) {
+      if(!br->b[e]) {
+        throw runtime_error("line " + to_string(br->id) +
+            " references bus " + to_string(br->bus_ids[e]) +
+            " which does not exist");
+      }
+    }
+  }
+
+  //incidence lists by counting sort on the bus, stable in branch order so
+  //that every bus sees its neighbors in the order the sequential loader
+  //gives them
+  vector<size_t> beg(nb+1, 0);
+  for(const Branch *br : brs) {
+    ++beg[br->b[0] - block + 1];
+    ++beg[br->b[1] - block + 1];
+  }
+  for(size_t i=0; i<nb; ++i) { beg[i+1] += beg[i]; }
+  vector<size_t> fill(beg.begin(), beg.end()-1), ends(beg[nb]);
+  for(long k=0; k<nbr; ++k) {
+    ends[fill[brs[k]->b[0] - block]++] = 2*k;
+    ends[fill[brs[k]->b[1] - block]++] = 2*k + 1;
+  }
+
+  long nbl = nb;
+  #pragma omp parallel for schedule(dynamic, 256)
+  for(long i=0; i<nbl; ++i) {
+    Bus &b = block[i];
+    b.neighbors.reserve(beg[i+1] - beg[i]);
+    for(size_t j=beg[i]; j<beg[i+1]; ++j) {
+      Branch *br = brs[ends[j]/2];
+      b.neighbors.push_back(Neighbor(br, br->b[1 - ends[j]%2]));
+    }
+  }
+
+  //the messages of the sequential loader, once everything is in place
+  vector<string> msgs{
+    "Found " + to_string(grid.buses.size()) + " buses",
+    "Found " + to_string(grid.generators.size()) + " generators",
+    "found " + to_string(grid.shunt_caps.size()) + " shunt capacitors"};
+  if(has_loads) {
+    msgs.push_back("Found " + to_string(grid.loads.size()) + " loads");
+  }
+  msgs.push_back("found " + to_string(grid.lines.size()) + " lines");
+  msgs.push_back("Found " + to_string(grid.transformers.size()) +
+                 " transformers");
+  if(log) { log->insert(log->end(), msgs.begin(), msgs.end()); }
+  else { for(const string &m : msgs) { cout << m << '\n'; } }
+
+  return grid;
+
+}
+
+void
+cypress::snapshotFromJson(string json, string snapshot) {
+
+  BSONObj bsob = fromjson(readFile(json));
+  std::ofstream out(snapshot, std::ios::binary);
+  if(!out.good()) {
+    throw runtime_error("Unable to write file " + snapshot);
+  }
+  out.write(bsob.objdata(), bsob.objsize());
+  out.close();
+  if(!out.good()) {
+    throw runtime_error("Unable to write file " + snapshot);
+  }
+
+}
+
 string 
 cypress::readFile(string filename) {
   //try to read input source
@@ -133,13 +436,7 @@ cypress::getBuses(const BSONObj &grid) {
   //and placing in the buses array
   vector<BSONElement> bus_elems = buses_bson.Array(); 
   for(const BSONElement &be : bus_elems) {
-    BSONObj bo = be.Obj();
-    size_t id = getRequiredInt(bo, "id");
-    double rating = getRequiredDouble(bo, "rating");
-    bool slack = getOptionalBool(bo, "slack", false);
-    Bus *b = new Bus(id, rating);
-    b->slack = slack;
-    buses.push_back(b);
+    buses.push_back(new Bus(getBus(be.Obj())));
   }
 
   cout << "Found " << buses.size() << " buses" << endl;
@@ -147,6 +444,16 @@ cypress::getBuses(const BSONObj &grid) {
   return move(buses);
 }
 
+Bus
+cypress::getBus(const BSONObj &bo) {
+  size_t id = getRequiredInt(bo, "id");
+  double rating = getRequiredDouble(bo, "rating");
+  bool slack = getOptionalBool(bo, "slack", false);
+  Bus b(id, rating);
+  b.slack = slack;
+  return b;
+}
+
 vector<Generator*> 
 cypress::getGenerators(const BSONObj &grid) {
   vector<Generator*> gens;
@@ -155,22 +462,8 @@ cypress::getGenerators(const BSONObj &grid) {
   vector<BSONElement> gen_elems = gens_bson.Array();
 
   for(const BSONElement &be : gen_elems) {
-    BSONObj bo = be.Obj();
-    int id = getRequiredInt(bo, "id");
-    string model = getRequiredString(bo, "model");
-    int bus = getRequiredInt(bo, "bus");
-    if(model == "static") {
-      vector<BSONElement> velem = getRequiredArray(bo, "v");
-      if(velem.size() != 2) {
-        throw runtime_error("complex numbers must be an array of two doubles");
-      }
-      double vm = velem[0].Double(),
-             va = velem[1].Double();
-      Generator *g = new StaticGen(std::polar(vm, va));
-      g->id = id;
-      g->bus_id = bus;
-      gens.push_back(g);
-    }
+    Generator *g = getGenerator(be.Obj());
+    if(g) { gens.push_back(g); }
   }
 
   cout << "Found " << gens.size() << " generators" << endl;
@@ -178,6 +471,55 @@ cypress::getGenerators(const BSONObj &grid) {
   return move(gens);
 }
 
+//nullptr for the generator models that are not loaded
+Generator*
+cypress::getGenerator(const BSONObj &bo) {
+  int id = getRequiredInt(bo, "id");
+  string model = getRequiredString(bo, "model");
+  int bus = getRequiredInt(bo, "bus");
+  if(model != "static" && model != "classical" &&
+     model != "fourth_order") { return nullptr; }
+
+  vector<BSONElement> velem = getRequiredArray(bo, "v");
+  if(velem.size() != 2) {
+    throw runtime_error("complex numbers must be an array of two doubles");
+  }
+  complex v = std::polar(velem[0].Double(), velem[1].Double());
+
+  Generator *g{nullptr};
+  if(model == "static") {
+    g = new StaticGen(v);
+  }
+  else if(model == "classical") {
+    g = new ClassicalGen(v,
+        getRequiredDouble(bo, "H"),
+        getOptionalDouble(bo, "D", 0.0),
+        getRequiredDouble(bo, "xdp"));
+  }
+  else {
+    g = new FourthOrderGen(v,
+        getRequiredDouble(bo, "H"),
+        getOptionalDouble(bo, "D", 0.0),
+        getRequiredDouble(bo, "xd"),
+        getRequiredDouble(bo, "xq"),
+        getRequiredDouble(bo, "xdp"),
+        getRequiredDouble(bo, "xqp"),
+        getRequiredDouble(bo, "Td0p"),
+        getRequiredDouble(bo, "Tq0p"));
+  }
+  g->id = id;
+  g->bus_id = bus;
+  g->qmin = getOptionalDouble(bo, "qmin", g->qmin);
+  g->qmax = getOptionalDouble(bo, "qmax", g->qmax);
+  g->zsub = {0, getOptionalDouble(bo, "xdpp", 0.0)};
+  g->c0 = getOptionalDouble(bo, "c0", g->c0);
+  g->c1 = getOptionalDouble(bo, "c1", g->c1);
+  g->c2 = getOptionalDouble(bo, "c2", g->c2);
+  g->pmin = getOptionalDouble(bo, "pmin", g->pmin);
+  g->pmax = getOptionalDouble(bo, "pmax", g->pmax);
+  return g;
+}
+
 void 
 cypress::resolveGeneratorBuses(Grid &g) {
   for(Generator *gen : g.generators) {
@@ -204,15 +546,7 @@ cypress::getShuntCapacitors(BSONObj grid_obj) {
     getRequiredArray(grid_obj, "shunt_capacitors");
 
   for(const BSONElement &be : cap_elems) {
-   BSONObj bo = be.Obj();
-   int id = getRequiredInt(bo, "id");
-   vector<BSONElement> y_vec =
-     getRequiredArray(bo, "y");
-   double g = y_vec[0].Double(),
-          b = y_vec[1].Double();
-   int bus_id = getRequiredInt(bo, "bus");
-   ShuntCap *sc = new ShuntCap(id, bus_id, {g,b});
-   caps.push_back(sc);
+   caps.push_back(getShuntCapacitor(be.Obj()));
   }
 
   cout << "found " << caps.size() << " shunt capacitors" << endl;
@@ -220,6 +554,17 @@ cypress::getShuntCapacitors(BSONObj grid_obj) {
   return move(caps);
 }
 
+ShuntCap*
+cypress::getShuntCapacitor(const BSONObj &bo) {
+  int id = getRequiredInt(bo, "id");
+  vector<BSONElement> y_vec =
+    getRequiredArray(bo, "y");
+  double g = y_vec[0].Double(),
+         b = y_vec[1].Double();
+  int bus_id = getRequiredInt(bo, "bus");
+  return new ShuntCap(id, bus_id, {g,b});
+}
+
 void 
 cypress::resolveShuntCaps(Grid &grid) {
   for(ShuntCap *sc : grid.shunt_caps) {
@@ -237,38 +582,141 @@ cypress::resolveShuntCaps(Grid &grid) {
   }
 }
 
+vector<Load*> 
+cypress::getLoads(const BSONObj &grid) {
+  vector<Load*> loads;
+
+  //voltage dependent loads are optional, constant power loads live in the
+  //schedule
+  if(grid["loads"].eoo()) { return loads; }
+
+  for(const BSONElement &be : getRequiredArray(grid, "loads")) {
+    loads.push_back(getLoad(be.Obj()));
+  }
+
+  cout << "Found " << loads.size() << " loads" << endl;
+
+  return move(loads);
+}
+
+Load*
+cypress::getLoad(const BSONObj &bo) {
+  int id = getRequiredInt(bo, "id");
+  string model = getRequiredString(bo, "model");
+  vector<BSONElement> s_vec = getRequiredArray(bo, "s");
+  if(s_vec.size() != 2) {
+    throw runtime_error("complex numbers must be an array of two doubles");
+  }
+  complex s0{s_vec[0].Double(), s_vec[1].Double()};
+
+  Load *l{nullptr};
+  if(model == "zip") {
+    auto shares = [&bo](const string &name) {
+      vector<BSONElement> v = getRequiredArray(bo, name);
+      if(v.size() != 3) {
+        throw runtime_error(name + " must be an array of three shares");
+      }
+      return array<double, 3>{{v[0].Double(), v[1].Double(),
+                               v[2].Double()}};
+    };
+    l = new ZipLoad(s0, shares("zip_p"), shares("zip_q"));
+  }
+  else if(model == "exponential") {
+    l = new ExponentialLoad(s0, getRequiredDouble(bo, "np"),
+                            getRequiredDouble(bo, "nq"));
+  }
+  else {
+    throw runtime_error("load " + to_string(id) +
+        " has unknown model " + model);
+  }
+  l->id = id;
+  l->bus_id = getRequiredInt(bo, "bus");
+  l->vn = getOptionalDouble(bo, "vn", 1.0);
+  return l;
+}
+
+void 
+cypress::resolveLoads(Grid &g) {
+  for(Load *l : g.loads) {
+    auto bus = find_if(g.buses.begin(), g.buses.end(),
+        [l](const Bus *b) {
+          return l->bus_id == b->id;
+        });
+    if(bus == g.buses.end()) {
+      throw runtime_error(
+          "load " + to_string(l->id) +
+          " references " + to_string(l->bus_id) +
+          " which does not exist");
+    }
+    l->bus = *bus;
+    (*bus)->load = l;
+  }
+}
+
 vector<Line*> 
 cypress::getLines(const BSONObj &grid_elem) {
   vector<Line*> lines;
   
   vector<BSONElement> le_arr = getRequiredArray(grid_elem, "lines");
   for(const BSONElement &be : le_arr) {
-    BSONObj bo = be.Obj();
-    int id = getRequiredInt(bo, "id");
-    string model = getRequiredString(bo, "model");
-    Line *l{nullptr};
-    if(model == "simple") {
-      vector<BSONElement> z_arr = getRequiredArray(bo, "z");
-      double r = z_arr[0].Double(),
-             x = z_arr[1].Double();
-      double charg_b = getOptionalDouble(bo, "charging_b", 0.0);
-      vector<BSONElement> b_arr = getRequiredArray(bo, "buses");
-      int b0 = b_arr[0].Int(),
-          b1 = b_arr[1].Int();
-      l = new SimpleLine({r,x}, {0, charg_b});
-      l->id = id;
-      l->bus_ids[0] = b0;
-      l->bus_ids[1] = b1;
-    }
-    else {
-      throw runtime_error("unknown line model type " + model);
-    }
-    lines.push_back(l);
+    lines.push_back(getLine(be.Obj()));
   }
   cout << "found " << lines.size() << " lines" << endl;
   return lines;
 }
 
+Line*
+cypress::getLine(const BSONObj &bo) {
+  int id = getRequiredInt(bo, "id");
+  string model = getRequiredString(bo, "model");
+  Line *l{nullptr};
+  if(model == "simple") {
+    vector<BSONElement> z_arr = getRequiredArray(bo, "z");
+    double r = z_arr[0].Double(),
+           x = z_arr[1].Double();
+    double charg_b = getOptionalDouble(bo, "charging_b", 0.0);
+    vector<BSONElement> b_arr = getRequiredArray(bo, "buses");
+    int b0 = b_arr[0].Int(),
+        b1 = b_arr[1].Int();
+    l = new SimpleLine({r,x}, {0, charg_b});
+    l->id = id;
+    l->bus_ids[0] = b0;
+    l->bus_ids[1] = b1;
+    l->smax = getOptionalDouble(bo, "smax", 0.0);
+  }
+  else if(model == "three_phase") {
+    //phase matrices are row major arrays of nine complex pairs
+    auto phases = [&bo](const string &name) {
+      array<complex, 9> m;
+      m.fill({0,0});
+      if(bo[name].eoo()) { return m; }
+      vector<BSONElement> v = getRequiredArray(bo, name);
+      if(v.size() != 9) {
+        throw runtime_error(name + " must be a 3x3 matrix");
+      }
+      for(size_t k=0; k<9; ++k) {
+        vector<BSONElement> c = v[k].Array();
+        m[k] = {c[0].Double(), c[1].Double()};
+      }
+      return m;
+    };
+    if(bo["zabc"].eoo()) {
+      throw runtime_error("three phase line " + to_string(id) +
+          " has no zabc");
+    }
+    vector<BSONElement> b_arr = getRequiredArray(bo, "buses");
+    l = new ThreePhaseLine(phases("zabc"), phases("yabc"));
+    l->id = id;
+    l->bus_ids[0] = b_arr[0].Int();
+    l->bus_ids[1] = b_arr[1].Int();
+    l->smax = getOptionalDouble(bo, "smax", 0.0);
+  }
+  else {
+    throw runtime_error("unknown line model type " + model);
+  }
+  return l;
+}
+
 vector<Transformer*> 
 cypress::getTransformers(const BSONObj &grid_bse) {
 
@@ -278,35 +726,40 @@ cypress::getTransformers(const BSONObj &grid_bse) {
     getRequiredArray(grid_bse, "transformers");
 
   for(const BSONElement &be : tfe_arr) {
-    const BSONObj bo = be.Obj();
-    int id = getRequiredInt(bo, "id");
-    vector<BSONElement> z_arr = getRequiredArray(bo, "z");
-    double r = z_arr[0].Double(),
-           x = z_arr[1].Double();
-    vector<BSONElement> t_arr = getRequiredArray(bo, "t");
-    double tr = t_arr[0].Double(),
-           ti = t_arr[1].Double();
-    vector<BSONElement> b_arr = getRequiredArray(bo, "buses");
-    double b0 = b_arr[0].Int(),
-           b1 = b_arr[1].Int();
-    string model = getRequiredString(bo, "model");
-    Transformer *tfmr{nullptr};
-    if(model == "simple") {
-      tfmr = new SimpleTransformer({r,x}, {tr, ti});
-      tfmr->id = id;
-      tfmr->bus_ids[0] = b0;
-      tfmr->bus_ids[1] = b1;
-    }
-    else {
-      throw runtime_error("unknown transformer model " + model);
-    }
-    tfmrs.push_back(tfmr);
+    tfmrs.push_back(getTransformer(be.Obj()));
   }
   cout << "Found " << tfmrs.size() << " transformers" << endl;
 
   return tfmrs;
 }
 
+Transformer*
+cypress::getTransformer(const BSONObj &bo) {
+  int id = getRequiredInt(bo, "id");
+  vector<BSONElement> z_arr = getRequiredArray(bo, "z");
+  double r = z_arr[0].Double(),
+         x = z_arr[1].Double();
+  vector<BSONElement> t_arr = getRequiredArray(bo, "t");
+  double tr = t_arr[0].Double(),
+         ti = t_arr[1].Double();
+  vector<BSONElement> b_arr = getRequiredArray(bo, "buses");
+  double b0 = b_arr[0].Int(),
+         b1 = b_arr[1].Int();
+  string model = getRequiredString(bo, "model");
+  Transformer *tfmr{nullptr};
+  if(model == "simple") {
+    tfmr = new SimpleTransformer({r,x}, {tr, ti});
+    tfmr->id = id;
+    tfmr->bus_ids[0] = b0;
+    tfmr->bus_ids[1] = b1;
+    tfmr->smax = getOptionalDouble(bo, "smax", 0.0);
+  }
+  else {
+    throw runtime_error("unknown transformer model " + model);
+  }
+  return tfmr;
+}
+
 gridworks::Glob<complex>
 cypress::schedule(std::string filename) {
   string src = readFile(filename);
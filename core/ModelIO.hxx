@@ -17,6 +17,29 @@ namespace cypress {
 gridworks::Grid 
 gridFromJson(std::string filename);
 
+//loads a grid from the BSON document at @data, a snapshot mapped into memory
+//loads without any parsing. The document must fit in the @size bytes
+//available at @data, a truncated or corrupt snapshot throws
+gridworks::Grid
+gridFromBson(const char *data, size_t size);
+
+//loads like gridFromBson, building the independent sections of the model
+//(buses, generators, shunt capacitors, loads, lines, transformers)
+//concurrently and linking them in a parallel pass. The buses are stored
+//contiguously. The messages the sequential loader prints as it goes are
+//appended to @log, or printed once loading is done if there is none
+gridworks::Grid
+gridFromBsonParallel(const char *data, size_t size,
+                     std::vector<std::string> *log = nullptr);
+
+gridworks::Grid
+gridFromJsonParallel(std::string filename,
+                     std::vector<std::string> *log = nullptr);
+
+//converts the grid model in the JSON file @json to a BSON snapshot file
+void
+snapshotFromJson(std::string json, std::string snapshot);
+
 std::string 
 readFile(std::string);
 
@@ -46,21 +69,42 @@ getOptionalDouble(const mongo::BSONObj &obj, const std::string &name,
 std::vector<gridworks::Bus*> 
 getBuses(const mongo::BSONObj &grid);
 
+gridworks::Bus
+getBus(const mongo::BSONObj &bus);
+
 std::vector<gridworks::Generator*> 
 getGenerators(const mongo::BSONObj &grid);
 
+gridworks::Generator*
+getGenerator(const mongo::BSONObj &gen);
+
 void 
 resolveGeneratorBuses(gridworks::Grid &g);
 
 std::vector<gridworks::ShuntCap*> 
 getShuntCapacitors(mongo::BSONObj grid_obj);
 
+gridworks::ShuntCap*
+getShuntCapacitor(const mongo::BSONObj &cap);
+
 void 
 resolveShuntCaps(gridworks::Grid &grid);
 
+std::vector<gridworks::Load*> 
+getLoads(const mongo::BSONObj &grid);
+
+gridworks::Load*
+getLoad(const mongo::BSONObj &load);
+
+void 
+resolveLoads(gridworks::Grid &g);
+
 std::vector<gridworks::Line*> 
 getLines(const mongo::BSONObj &grid_elem);
 
+gridworks::Line*
+getLine(const mongo::BSONObj &line);
+
 template <class T>
 void resolveBranches(std::vector<T*> &brs, 
                      std::vector<gridworks::Bus*> &buses) {
@@ -95,6 +139,9 @@ void resolveBranches(std::vector<T*> &brs,
 std::vector<gridworks::Transformer*> 
 getTransformers(const mongo::BSONObj &grid_bse);
 
+gridworks::Transformer*
+getTransformer(const mongo::BSONObj &transformer);
+
 gridworks::Glob<std::complex<double>>
 schedule(std::string filename);
 
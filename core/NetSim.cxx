@@ -0,0 +1,411 @@
+#include "NetSim.hxx"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+using namespace gridworks;
+using namespace gridworks::ip;
+using std::vector;
+using std::runtime_error;
+using std::to_string;
+
+static const double inf = std::numeric_limits<double>::infinity();
+
+//CalendarQueue ---------------------------------------------------------------
+
+//entry @a leaves after @b
+static bool later(const CalendarQueue::Entry &a, const CalendarQueue::Entry &b)
+{
+  return a.t > b.t || (a.t == b.t && a.seq > b.seq);
+}
+
+//the day of @t, events are filed and found due by this one function so
+//the two never disagree at a day boundary
+static uint64_t dayOf(double t, double width)
+{
+  return t > 0 ? static_cast<uint64_t>(std::floor(t / width)) : 0;
+}
+
+static size_t bucketOf(double t, double width, size_t nb)
+{
+  return dayOf(t, width) % nb;
+}
+
+CalendarQueue::CalendarQueue() : buckets(2) {}
+
+void CalendarQueue::push(double t, uint32_t id)
+{
+  Entry e{t, seq++, id};
+  size_t nb = buckets.size();
+  vector<Entry> &b = buckets[bucketOf(t, width, nb)];
+  b.push_back(e);
+  std::push_heap(b.begin(), b.end(), later);
+  ++size;
+
+  //an event before the current day moves the calendar back to it
+  if(dayOf(t, width) < day)
+  {
+    day = dayOf(t, width);
+    cur = day % nb;
+  }
+
+  if(size > 2*nb) { resize(2*nb); }
+}
+
+size_t CalendarQueue::locate()
+{
+  size_t nb = buckets.size();
+  for(size_t i=0; i<nb; ++i)
+  {
+    const vector<Entry> &b = buckets[cur];
+    if(!b.empty() && dayOf(b.front().t, width) <= day) { return cur; }
+    cur = (cur + 1) % nb;
+    ++day;
+  }
+
+  //nothing within a year, jump straight to the earliest event
+  size_t k = nb;
+  for(size_t i=0; i<nb; ++i)
+  {
+    if(buckets[i].empty()) { continue; }
+    if(k == nb || later(buckets[k].front(), buckets[i].front())) { k = i; }
+  }
+  day = dayOf(buckets[k].front().t, width);
+  cur = k;
+  return k;
+}
+
+CalendarQueue::Entry CalendarQueue::pop()
+{
+  vector<Entry> &b = buckets[locate()];
+  std::pop_heap(b.begin(), b.end(), later);
+  Entry e = b.back();
+  b.pop_back();
+  --size;
+  last = e.t;
+
+  size_t nb = buckets.size();
+  if(nb > 2 && size < nb/2) { resize(nb/2); }
+  return e;
+}
+
+double CalendarQueue::next()
+{
+  return buckets[locate()].front().t;
+}
+
+void CalendarQueue::resize(size_t nb)
+{
+  vector<Entry> all;
+  all.reserve(size);
+  for(vector<Entry> &b : buckets) { all.insert(all.end(), b.begin(), b.end()); }
+  std::sort(all.begin(), all.end(),
+      [](const Entry &a, const Entry &b) { return later(b, a); });
+
+  //a day is a few times the average gap between the earliest events, gaps
+  //between equal times say nothing about the spacing
+  double gaps{0};
+  size_t ng{0};
+  for(size_t i=1; i<all.size() && i<=25; ++i)
+  {
+    double d = all[i].t - all[i-1].t;
+    if(d > 0) { gaps += d; ++ng; }
+  }
+  if(ng > 0) { width = 3 * gaps / ng; }
+
+  //pushed in order each bucket is already a heap
+  buckets.assign(nb, vector<Entry>{});
+  for(const Entry &e : all) { buckets[bucketOf(e.t, width, nb)].push_back(e); }
+
+  double base = all.empty() ? last : all.front().t;
+  day = dayOf(base, width);
+  cur = day % nb;
+}
+
+//Simulator -------------------------------------------------------------------
+
+Simulator::Simulator(const Network &net, double rate_unit,
+    double latency_unit)
+  : n{net.hosts.size()}
+{
+  for(size_t i=0; i<n; ++i) { index[net.hosts[i]] = i; }
+
+  size_t nl = net.links.size();
+  ends.resize(2*nl);
+  bps.resize(nl);
+  delay.resize(nl);
+  busy.assign(2*nl, 0);
+  abeg.assign(n+1, 0);
+  for(size_t l=0; l<nl; ++l)
+  {
+    const Link &k = *net.links[l];
+    for(size_t e=0; e<2; ++e)
+    {
+      auto h = index.find(k.endpoints[e]);
+      if(h == index.end()) {
+        throw runtime_error("link " + to_string(l) + " is not connected");
+      }
+      ends[2*l+e] = h->second;
+      ++abeg[h->second+1];
+    }
+    if(!(k.capacity > 0)) {
+      throw runtime_error("link " + to_string(l) + " has no capacity");
+    }
+    bps[l] = k.capacity * rate_unit;
+    delay[l] = k.latency * latency_unit;
+  }
+
+  for(size_t i=0; i<n; ++i) { abeg[i+1] += abeg[i]; }
+  anbr.resize(abeg[n]);
+  alink.resize(abeg[n]);
+  vector<int> fill(abeg.begin(), abeg.end()-1);
+  for(size_t l=0; l<nl; ++l)
+  {
+    int a = ends[2*l], b = ends[2*l+1];
+    anbr[fill[a]] = b;
+    alink[fill[a]++] = l;
+    anbr[fill[b]] = a;
+    alink[fill[b]++] = l;
+  }
+
+  traffic.assign(n, 0);
+}
+
+void Simulator::send(double t, uint32_t src, uint32_t dst, uint32_t bytes,
+    uint32_t tag, double value)
+{
+  if(src >= n || dst >= n) {
+    throw runtime_error("message between unknown hosts " + to_string(src) +
+                        " and " + to_string(dst));
+  }
+  ++traffic[src];
+  ++traffic[dst];
+
+  Msg m{t, src, dst, src, bytes, tag, 0, -1, false, value};
+  if(src != dst)
+  {
+    m.tree = route(src, dst, m.up);
+    if(m.tree < 0)
+    {
+      ++unreachable;
+      return;
+    }
+    ++trees[m.tree].inflight;
+  }
+
+  uint32_t id;
+  if(!spare.empty())
+  {
+    id = spare.back();
+    spare.pop_back();
+    msgs[id] = m;
+  }
+  else
+  {
+    id = msgs.size();
+    msgs.push_back(m);
+  }
+  queue.push(std::max(t, now), id);
+}
+
+void Simulator::at(double t, Action f)
+{
+  timers.push({std::max(t, now), timer_seq});
+  actions[timer_seq++] = std::move(f);
+}
+
+void Simulator::run(double tend)
+{
+  while(true)
+  {
+    double tq = queue.empty() ? inf : queue.next(),
+           tt = timers.empty() ? inf : timers.top().first;
+    double t = std::min(tq, tt);
+    if(t > tend || t == inf) { break; }
+    now = t;
+    ++events;
+
+    //timers go first at equal times so that a sample sees every message
+    //delivered before it
+    if(tt <= tq)
+    {
+      uint64_t s = timers.top().second;
+      timers.pop();
+      auto a = actions.find(s);
+      Action f = std::move(a->second);
+      actions.erase(a);
+      f();
+      continue;
+    }
+    forward(queue.pop().id);
+  }
+  now = std::max(now, tend);
+}
+
+void Simulator::release(uint32_t id)
+{
+  if(msgs[id].tree >= 0) { --trees[msgs[id].tree].inflight; }
+  spare.push_back(id);
+}
+
+void Simulator::forward(uint32_t id)
+{
+  Msg &m = msgs[id];
+  if(m.at == m.dst)
+  {
+    Delivery d{now, m.sent, m.src, m.dst, m.bytes, m.tag, m.value, m.hops};
+    ++delivered;
+    release(id);
+    //the handler may send, which can move %msgs
+    if(deliver) { deliver(d); }
+    return;
+  }
+
+  const Tree &tr = trees[m.tree];
+  int h = m.at, nh, l;
+  if(m.up)
+  {
+    nh = tr.parent[h];
+    l = tr.plink[h];
+  }
+  else
+  {
+    //the child whose subtree holds the destination
+    int td = tr.tin[m.dst];
+    const int *cb = tr.child.data() + tr.cbeg[h],
+              *ce = tr.child.data() + tr.cbeg[h+1];
+    const int *c = std::upper_bound(cb, ce, td,
+        [&tr](int x, int k) { return x < tr.tin[k]; }) - 1;
+    nh = *c;
+    l = tr.plink[nh];
+  }
+
+  double &bz = busy[2*l + (ends[2*l] == h ? 0 : 1)];
+  double start = std::max(now, bz);
+  if(start - now > max_backlog)
+  {
+    ++dropped;
+    release(id);
+    return;
+  }
+  bz = start + 8.0 * m.bytes / bps[l];
+  m.at = nh;
+  ++m.hops;
+  queue.push(bz + delay[l], id);
+}
+
+int Simulator::route(uint32_t src, uint32_t dst, bool &up)
+{
+  int t;
+  auto d = rooted.find(dst);
+  if(d != rooted.end())
+  {
+    t = d->second;
+    up = true;
+  }
+  else
+  {
+    auto s = rooted.find(src);
+    if(s != rooted.end())
+    {
+      t = s->second;
+      up = false;
+    }
+    else
+    {
+      uint32_t root = traffic[dst] >= traffic[src] ? dst : src;
+      t = build(root);
+      up = root == dst;
+    }
+  }
+  return trees[t].tin[up ? src : dst] < 0 ? -1 : t;
+}
+
+int Simulator::build(uint32_t root)
+{
+  //reuse the slot of the idle tree with the least traffic once full
+  int slot = trees.size();
+  if(trees.size() >= max_trees)
+  {
+    for(size_t k=0; k<trees.size(); ++k)
+    {
+      if(trees[k].inflight > 0) { continue; }
+      if(slot == static_cast<int>(trees.size()) ||
+         traffic[trees[k].root] < traffic[trees[slot].root]) {
+        slot = k;
+      }
+    }
+  }
+  if(slot == static_cast<int>(trees.size())) { trees.emplace_back(); }
+  else { rooted.erase(trees[slot].root); }
+
+  Tree &t = trees[slot];
+  t.root = root;
+  t.inflight = 0;
+  t.parent.assign(n, -1);
+  t.plink.assign(n, -1);
+
+  //dijkstra by latency, a hop costs a little so that zero latency links
+  //still give the shortest path in hops
+  vector<double> dist(n, inf);
+  using Item = std::pair<double, int>;
+  std::priority_queue<Item, vector<Item>, std::greater<Item>> pq;
+  dist[root] = 0;
+  pq.push({0, static_cast<int>(root)});
+  while(!pq.empty())
+  {
+    Item x = pq.top();
+    pq.pop();
+    int h = x.second;
+    if(x.first > dist[h]) { continue; }
+    for(int k=abeg[h]; k<abeg[h+1]; ++k)
+    {
+      int g = anbr[k], l = alink[k];
+      double nd = x.first + delay[l] + 1e-12;
+      if(nd < dist[g])
+      {
+        dist[g] = nd;
+        t.parent[g] = h;
+        t.plink[g] = l;
+        pq.push({nd, g});
+      }
+    }
+  }
+
+  //children by host, then a depth first pass numbers the subtrees, which
+  //leaves each child list sorted by tin
+  t.cbeg.assign(n+1, 0);
+  for(size_t h=0; h<n; ++h) {
+    if(t.parent[h] >= 0) { ++t.cbeg[t.parent[h]+1]; }
+  }
+  for(size_t h=0; h<n; ++h) { t.cbeg[h+1] += t.cbeg[h]; }
+  t.child.resize(t.cbeg[n]);
+  vector<int> fill(t.cbeg.begin(), t.cbeg.end()-1);
+  for(size_t h=0; h<n; ++h) {
+    if(t.parent[h] >= 0) { t.child[fill[t.parent[h]]++] = h; }
+  }
+
+  t.tin.assign(n, -1);
+  t.tout.assign(n, -1);
+  int clock{0};
+  vector<std::pair<int,int>> stack{{static_cast<int>(root), 0}};
+  t.tin[root] = clock++;
+  while(!stack.empty())
+  {
+    std::pair<int,int> &f = stack.back();
+    int h = f.first, k = t.cbeg[h] + f.second;
+    if(k == t.cbeg[h+1])
+    {
+      t.tout[h] = clock - 1;
+      stack.pop_back();
+      continue;
+    }
+    ++f.second;
+    int c = t.child[k];
+    t.tin[c] = clock++;
+    stack.push_back({c, 0});
+  }
+
+  rooted[root] = slot;
+  return slot;
+}
@@ -0,0 +1,167 @@
+#ifndef GW_NETSIM
+#define GW_NETSIM
+
+#include "IP.hxx"
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <unordered_map>
+#include <vector>
+
+namespace gridworks { namespace ip {
+
+/*=============================================================================
+ * The #CalendarQueue is the pending event set of the #Simulator (Brown's
+ * calendar queue). Events hash by time into a ring of buckets one %width
+ * wide and are dequeued by walking the ring one "day" at a time, so both
+ * operations take constant expected time. The ring doubles or halves with
+ * the number of events and the width is resampled from the spacing of the
+ * earliest events when it does. Buckets are heaps rather than sorted lists
+ * since a burst of events at one instant all lands in one bucket. Equal
+ * times leave in the order they were pushed
+ *===========================================================================*/
+struct CalendarQueue {
+  //types ---------------------------------------------------------------------
+  struct Entry {
+    double    t;
+    uint64_t  seq;
+    uint32_t  id;
+  };
+
+  //data ----------------------------------------------------------------------
+  std::vector<std::vector<Entry>> buckets; //heaps, earliest on top
+  double    width{1.0};
+  uint64_t  day{0};                 //current day, [day, day+1) widths
+  double    last{0};                //time of the last event popped
+  size_t    cur{0}, size{0};
+  uint64_t  seq{0};
+
+  //constructors --------------------------------------------------------------
+  CalendarQueue();
+
+  //methods -------------------------------------------------------------------
+  void push(double t, uint32_t id);
+  Entry pop();
+  bool empty() const { return size == 0; }
+
+  //time of the earliest event, the queue must not be empty
+  double next();
+
+  void resize(size_t nb);
+
+  //advances to the bucket holding the earliest event and returns it
+  size_t locate();
+};
+
+/*=============================================================================
+ * A #Delivery is a message that reached its destination host
+ *===========================================================================*/
+struct Delivery {
+  double    t, sent;                //arrival and send time, seconds
+  uint32_t  src, dst;               //host indices
+  uint32_t  bytes, tag;
+  double    value;
+  uint32_t  hops;
+};
+
+/*=============================================================================
+ * The #Simulator is a discrete event simulation of message delivery over an
+ * ip::%Network. Messages travel hop by hop along shortest latency paths, at
+ * each hop they are serialized onto the link in FIFO order behind the
+ * messages already queued in that direction, bytes over capacity, and
+ * arrive one link latency after their last bit left. Link capacity is in
+ * %rate_unit bits per second and latency in %latency_unit seconds, Mbit/s
+ * and milliseconds by default as in the topDL model.
+ *
+ * Paths come from shortest path trees that are built on demand and cached,
+ * a message follows the tree of its destination to the root or the tree of
+ * its source down to the destination, whichever exists, so a control centre
+ * talking to every host needs a single tree. The host with the most traffic
+ * roots a new tree. Timers run arbitrary actions at a given time and are
+ * how the simulation is coupled with the grid, see #CoSimulation
+ *===========================================================================*/
+struct Simulator {
+  //types ---------------------------------------------------------------------
+  using Handler = std::function<void(const Delivery&)>;
+  using Action = std::function<void()>;
+
+  //a shortest path tree, hosts in depth first order [tin, tout]
+  struct Tree {
+    uint32_t          root;
+    std::vector<int>  parent, plink,  //parent host and link towards it
+                      tin, tout,
+                      cbeg, child;    //children of each host, by tin
+    size_t            inflight{0};
+  };
+
+  //a message in flight, at host %at
+  struct Msg {
+    double    sent;
+    uint32_t  src, dst, at, bytes, tag, hops;
+    int       tree;
+    bool      up;                   //towards the root of its tree
+    double    value;
+  };
+
+  //data ----------------------------------------------------------------------
+  size_t                n{0};       //hosts
+  std::vector<int>      abeg, anbr, alink; //host adjacency
+  std::vector<int>      ends;       //the two end hosts of every link
+  std::vector<double>   bps, delay; //link rate and latency, SI units
+  std::vector<double>   busy;       //per link direction, when the
+                                    //transmitter frees up
+  std::unordered_map<const Host*, int> index;
+
+  std::vector<Tree>     trees;
+  std::unordered_map<uint32_t, int> rooted; //tree of each root host
+  std::vector<size_t>   traffic;    //messages sent from or to each host
+  size_t                max_trees{64};
+
+  CalendarQueue         queue;
+  std::vector<Msg>      msgs;
+  std::vector<uint32_t> spare;      //reusable slots of %msgs
+  std::priority_queue<std::pair<double, uint64_t>,
+                      std::vector<std::pair<double, uint64_t>>,
+                      std::greater<std::pair<double, uint64_t>>> timers;
+  std::unordered_map<uint64_t, Action> actions;
+  uint64_t              timer_seq{0};
+
+  double                now{0},
+                        max_backlog{std::numeric_limits<double>::infinity()};
+                                    //longest wait for a link before the
+                                    //message is dropped, seconds
+  Handler               deliver;
+  size_t                events{0}, delivered{0}, dropped{0},
+                        unreachable{0};
+
+  //constructors --------------------------------------------------------------
+  explicit Simulator(const Network &net, double rate_unit = 1e6,
+                     double latency_unit = 1e-3);
+
+  //methods -------------------------------------------------------------------
+  //sends a message of @bytes from host @src to host @dst at time @t, hosts
+  //are indices into Network::hosts
+  void send(double t, uint32_t src, uint32_t dst, uint32_t bytes,
+            uint32_t tag = 0, double value = 0);
+
+  //runs @f at time @t
+  void at(double t, Action f);
+
+  //processes every event up to and including time @tend
+  void run(double tend);
+
+  //moves message @id one hop on, or delivers it
+  void forward(uint32_t id);
+  void release(uint32_t id);
+
+  //the tree routing a message between @src and @dst, -1 if there is none and
+  //none can be built
+  int route(uint32_t src, uint32_t dst, bool &up);
+
+  int build(uint32_t root);
+};
+
+}}
+
+#endif
@@ -1,4 +1,9 @@
 #include "PowerFlow.hxx"
+#include "SolverTuning.hxx"
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <unistd.h>
 
 using namespace gridworks;
 using std::string;
@@ -6,16 +11,17 @@ using std::stringstream;
 using std::endl;
 
 PowerFlow::PowerFlow(Grid *g, Glob<complex> state, Glob<complex> sSch,
-    double thresh)
+    double thresh, SymbolicCache *cache)
   : G{g}, 
     Y{ymatrix(*g)}, 
     state{state}, 
     sSch{sSch},
     dSch(g->buses.size()),
-    J{G, Y, state},
+    J{G, Y, state, cache},
     dX(J.m->n),
     dS(J.m->n),
-    thresh{thresh}
+    thresh{thresh},
+    cache{cache}
 { 
 
   init_mkl();
@@ -28,12 +34,19 @@ PowerFlow::PowerFlow(Grid *g, Glob<complex> state, Glob<complex> sSch,
 PowerFlow::~PowerFlow()
 {
   dss_delete(mkl_handle, dss_solve_opt);
+  if(sp_analyzed) { dss_delete(mkl_handle_sp, dss_solve_opt); }
   mkl_free_buffers();
 }
 
 void PowerFlow::calc_sCalc()
 {
   sCalc = G->sCalc(state, Y); 
+  const LoadBlock &lb = G->loadBlock;
+  lb.evaluate(state.data, loads);
+  for(size_t k=0; k<lb.n; ++k) {
+    sCalc.data[lb.bus.data[k]] += complex{loads.p[k], loads.q[k]};
+  }
+  if(seen.data) { std::copy(state.data, state.data + seen.sz, seen.data); }
 }
     
 void PowerFlow::calc_dSch()
@@ -41,46 +54,181 @@ void PowerFlow::calc_dSch()
   size_t n = G->buses.size();
   for(size_t i=0; i<n; ++i) 
     dSch.data[i] = sSch.data[i] - sCalc.data[i];
+  if(seenSch.data) { std::copy(sSch.data, sSch.data + n, seenSch.data); }
 }
     
-void PowerFlow::calc_dS()
+//the mismatch rows of the buses [@b, @e) of one block
+template <BusKind K>
+static void mismatchBlock(const BusBlocks &bb, size_t b, size_t e,
+                          const complex *dSch, double *dS)
 {
-  for(size_t i=0; i<G->buses.size(); ++i)
+  const int *order = bb.order.data();
+  const sindex *j0 = bb.j0.data(), *j1 = bb.j1.data();
+  for(size_t k=b; k<e; ++k)
   {
-    Bus &b = *G->buses[i];
-    if(b.slack) { continue; }
-    if(b.generator) { dS.data[b.jidx[0]] = dSch.data[i].real(); }
-    if(!b.generator) 
-    { 
-      dS.data[b.jidx[0]] = dSch.data[i].real();
-      dS.data[b.jidx[1]] = dSch.data[i].imag(); 
-    }
+    dS[j0[k]] = dSch[order[k]].real();
+    if(K == BusKind::PVQ) { dS[j1[k]] = 0.0; }
+    if(K == BusKind::PQ) { dS[j1[k]] = dSch[order[k]].imag(); }
   }
 }
-    
-void PowerFlow::update_state()
+
+//the newton update of the voltages of the buses [@b, @e) of one block,
+//the magnitude moves only where it is not controlled
+template <BusKind K>
+static void stateBlock(const BusBlocks &bb, size_t b, size_t e,
+                       const double *dX, complex *v, int threads)
 {
   using std::abs;
   using std::arg;
   using std::polar;
 
-  for(size_t i=0; i<G->buses.size(); ++i)
+  const int *order = bb.order.data();
+  const sindex *j0 = bb.j0.data(), *j1 = bb.j1.data();
+  #pragma omp parallel for num_threads(threads) if(threads > 1)
+  for(size_t k=b; k<e; ++k)
   {
-    Bus &b = *G->buses[i]; 
-    complex &vi = state.data[i];
+    complex &vi = v[order[k]];
+    if(K == BusKind::PQ) {
+      vi = polar(abs(vi) + abs(vi) * dX[j1[k]], arg(vi) + dX[j0[k]]);
+    }
+    else { vi = polar(abs(vi), arg(vi) + dX[j0[k]]); }
+  }
+}
 
-    if(b.slack) { continue; }
-    if(b.generator) 
-    { 
-      vi = polar( abs(vi), 
-                  arg(vi) + dX.data[b.jidx[0]] );
+void PowerFlow::calc_dS()
+{
+  const BusBlocks &bb = J.blocks;
+  mismatchBlock<BusKind::PV>(bb, bb.first(BusKind::PV), bb.last(BusKind::PV),
+                             dSch.data, dS.data);
+  mismatchBlock<BusKind::PVQ>(bb, bb.first(BusKind::PVQ),
+                              bb.last(BusKind::PVQ), dSch.data, dS.data);
+  mismatchBlock<BusKind::PQ>(bb, bb.first(BusKind::PQ), bb.last(BusKind::PQ),
+                             dSch.data, dS.data);
+}
+    
+//the injection of the bus at position @k of the blocks, as calc_sCalc
+//computes it
+static complex injection(const BusBlocks &bb, size_t k, const complex *x,
+                         const complex *yv, const LoadBlock &lb,
+                         LoadValues &lv)
+{
+  int i = bb.order[k];
+  complex yii = yv[bb.ydiag[k]];
+  double v2 = std::pow(std::abs(x[i]), 2),
+         P = v2 * yii.real(),
+         Q = -v2 * yii.imag();
+  for(sindex n=bb.nbeg[k]; n<bb.nbeg[k+1]; ++n)
+  {
+    Partials d = partials(x[i], x[bb.nbus[n]], yv[bb.ypos[n]]);
+    P += d.dPdM;
+    Q += d.dQdM;
+  }
+  complex s{P, Q};
+  if(i + 1 < int(lb.bbeg.size()))
+  {
+    for(int l=lb.bbeg[i]; l<lb.bbeg[i+1]; ++l)
+    {
+      lb.evaluate(x, lb.bload[l], lv);
+      s += complex{lv.p[lb.bload[l]], lv.q[lb.bload[l]]};
     }
-    if(!b.generator) 
-    { 
-      vi = polar( abs(vi) + abs(vi) * dX.data[b.jidx[1]], 
-                  arg(vi) + dX.data[b.jidx[0]] );
+  }
+  return s;
+}
+
+//Brings sCalc, dSch, dS and the jacobian up to date with the state and the
+//schedule. Incrementally only the buses that moved by more than dirty_tol
+//and their neighbors are evaluated again, a bus whose schedule alone moved
+//only gets its mismatch. Buses below the tolerance are compared against the
+//values they were last evaluated at, so small moves add up until they are
+//picked up instead of drifting away, and a full evaluation every full_every
+//calls bounds what is left. Finding the moved buses is one pass of
+//comparisons, the evaluations are the expensive part
+void PowerFlow::evaluate(bool full)
+{
+  size_t n = G->buses.size();
+  if(incremental && !seen.data)
+  {
+    seen = Glob<complex>(n);
+    seenSch = Glob<complex>(n);
+    mark.assign(n, 0);
+    full = true;
+  }
+  if(!incremental || full || since_full >= full_every)
+  {
+    calc_sCalc();
+    calc_dSch();
+    calc_dS();
+    J.update();
+    since_full = 0;
+    evaluated = n;
+    return;
+  }
+  ++since_full;
+
+  const BusBlocks &bb = J.blocks;
+  const LoadBlock &lb = G->loadBlock;
+  dirty.clear();
+  moved.clear();
+  auto touch = [this](int i, char m)
+  {
+    if(!mark[i]) { dirty.push_back(i); }
+    mark[i] = std::max(mark[i], m);
+  };
+  for(size_t i=0; i<n; ++i)
+  {
+    if(std::abs(state.data[i] - seen.data[i]) > dirty_tol)
+    {
+      seen.data[i] = state.data[i];
+      touch(i, 2);
+      size_t k = bb.at[i];
+      for(sindex m=bb.nbeg[k]; m<bb.nbeg[k+1]; ++m) {
+        touch(bb.nbus[m], 2);
+      }
+    }
+    if(std::abs(sSch.data[i] - seenSch.data[i]) > dirty_tol)
+    {
+      seenSch.data[i] = sSch.data[i];
+      touch(i, 1);
     }
   }
+
+  for(int i : dirty)
+  {
+    size_t k = bb.at[i];
+    if(mark[i] == 2)
+    {
+      sCalc.data[i] = injection(bb, k, state.data, J.y.v, lb, loads);
+      moved.push_back(i);
+    }
+    dSch.data[i] = sSch.data[i] - sCalc.data[i];
+    switch(bb.kind(k))
+    {
+      case BusKind::Slack: break;
+      case BusKind::PV: dS.data[bb.j0[k]] = dSch.data[i].real(); break;
+      case BusKind::PVQ:
+        dS.data[bb.j0[k]] = dSch.data[i].real();
+        dS.data[bb.j1[k]] = 0.0;
+        break;
+      case BusKind::PQ:
+        dS.data[bb.j0[k]] = dSch.data[i].real();
+        dS.data[bb.j1[k]] = dSch.data[i].imag();
+        break;
+    }
+    mark[i] = 0;
+  }
+  J.update(moved);
+  evaluated = moved.size();
+}
+
+void PowerFlow::update_state()
+{
+  const BusBlocks &bb = J.blocks;
+  stateBlock<BusKind::PV>(bb, bb.first(BusKind::PV), bb.last(BusKind::PV),
+                          dX.data, state.data, J.threads);
+  stateBlock<BusKind::PVQ>(bb, bb.first(BusKind::PVQ), bb.last(BusKind::PVQ),
+                           dX.data, state.data, J.threads);
+  stateBlock<BusKind::PQ>(bb, bb.first(BusKind::PQ), bb.last(BusKind::PQ),
+                          dX.data, state.data, J.threads);
 }
     
 void PowerFlow::mkl_death()
@@ -97,7 +245,43 @@ void PowerFlow::init_mkl()
   if(mkl_err != MKL_DSS_SUCCESS) { mkl_death(); }
 }
 
-void PowerFlow::step()
+//Drops the symbolic analysis, the next solve starts over with a fresh DSS
+//handle
+void PowerFlow::reset_mkl()
+{
+  dss_delete(mkl_handle, dss_solve_opt);
+  init_mkl();
+  analyzed = false;
+  if(sp_analyzed)
+  {
+    dss_delete(mkl_handle_sp, dss_solve_opt);
+    sp_analyzed = false;
+  }
+}
+
+//Applies @c, a change of ordering starts over with a fresh DSS handle
+void PowerFlow::configure(const SolverConfig &c)
+{
+  if(c.reorder != dss_reorder_opt) { reset_mkl(); }
+  dss_reorder_opt = c.reorder;
+  dss_factor_opt = c.factor;
+  if(c.mkl_threads > 0) { mkl_set_num_threads(c.mkl_threads); }
+  J.threads = std::max(1, c.kernel_threads);
+  mixed_precision = c.mixed_precision;
+  sp_stalled = false;
+}
+
+SolverConfig PowerFlow::config() const
+{
+  SolverConfig c;
+  c.reorder = dss_reorder_opt;
+  c.factor = dss_factor_opt;
+  c.kernel_threads = J.threads;
+  c.mixed_precision = mixed_precision;
+  return c;
+}
+
+void PowerFlow::analyze()
 {
   //structure
   mkl_err = dss_define_structure(
@@ -105,9 +289,77 @@ void PowerFlow::step()
       J.m->r, J.m->n, J.m->n, J.m->c, J.m->s);
   if(mkl_err != MKL_DSS_SUCCESS) { mkl_death(); }
 
-  //reorder
-  mkl_err = dss_reorder(mkl_handle, dss_reorder_opt, 0);
+  reorder(mkl_handle);
+  analyzed = true;
+}
+
+//Computes the fill reducing ordering of J on @handle, or takes it from the
+//symbolic cache when one is attached and holds it for this topology and
+//%dss_reorder_opt, so that tuning the ordering times each candidate
+void PowerFlow::reorder(_MKL_DSS_HANDLE_t &handle)
+{
+  if(!cache)
+  {
+    mkl_err = dss_reorder(handle, dss_reorder_opt, 0);
+    if(mkl_err != MKL_DSS_SUCCESS) { mkl_death(); }
+    return;
+  }
+
+  vector<sindex> perm = cache->order(J, dss_reorder_opt);
+  if(perm.empty())
+  {
+    perm.resize(J.m->n);
+    _INTEGER_t opt = dss_reorder_opt + MKL_DSS_GET_ORDER;
+    mkl_err = dss_reorder(handle, opt, perm.data());
+    if(mkl_err != MKL_DSS_SUCCESS) { mkl_death(); }
+    cache->store(J, perm, dss_reorder_opt);
+  }
+  else
+  {
+    _INTEGER_t opt = MKL_DSS_MY_ORDER;
+    mkl_err = dss_reorder(handle, opt, perm.data());
+    if(mkl_err != MKL_DSS_SUCCESS) { mkl_death(); }
+  }
+}
+
+void PowerFlow::analyze_sp()
+{
+  _INTEGER_t sp_opt = dss_opt + MKL_DSS_SINGLE_PRECISION;
+  mkl_err = dss_create(mkl_handle_sp, sp_opt);
   if(mkl_err != MKL_DSS_SUCCESS) { mkl_death(); }
+  sp_analyzed = true;
+
+  mkl_err = dss_define_structure(
+      mkl_handle_sp, dss_struct_opt, 
+      J.m->r, J.m->n, J.m->n, J.m->c, J.m->s);
+  if(mkl_err != MKL_DSS_SUCCESS) { mkl_death(); }
+
+  reorder(mkl_handle_sp);
+
+  fJ = Glob<float>(J.m->s);
+  fR = Glob<float>(J.m->n);
+  fC = Glob<float>(J.m->n);
+  rX = Glob<double>(J.m->n);
+}
+
+//Switches the newton solve to a domain decomposition over @k subdomains
+void PowerFlow::decompose(int k)
+{
+  dd = std::make_shared<DomainSolver>(J, k);
+}
+
+void PowerFlow::solve()
+{
+  if(dd)
+  {
+    dd->factor();
+    dd->solve(dS.data, dX.data);
+    return;
+  }
+
+  if(!analyzed) { analyze(); }
+
+  if(mixed_precision && !sp_stalled && solve_mixed()) { return; }
 
   //factor
   mkl_err = dss_factor_real(mkl_handle, dss_factor_opt, J.m->v);
@@ -117,13 +369,74 @@ void PowerFlow::step()
   mkl_err = 
     dss_solve_real(mkl_handle, dss_solve_opt, dS.data, nRhs, dX.data);
   if(mkl_err != MKL_DSS_SUCCESS) { mkl_death(); }
+}
+
+//Solves J dX = dS using a single precision factorization of J followed by
+//iterative refinement where the residual is computed in double precision
+//against J.m. Returns false if refinement stalls before reaching refine_tol,
+//in which case the caller falls back to a double precision factorization
+bool PowerFlow::solve_mixed()
+{
+  if(!sp_analyzed) { analyze_sp(); }
+
+  sindex n = J.m->n;
+  for(sindex i=0; i<J.m->s; ++i) 
+  { 
+    fJ.data[i] = static_cast<float>(J.m->v[i]); 
+  }
+
+  mkl_err = dss_factor_real(mkl_handle_sp, dss_factor_opt, fJ.data);
+  if(mkl_err != MKL_DSS_SUCCESS) { mkl_death(); }
+
+  double target{0};
+  for(sindex i=0; i<n; ++i) 
+  { 
+    target = std::max(target, std::abs(dS.data[i]));
+    fR.data[i] = static_cast<float>(dS.data[i]);
+  }
+  target *= refine_tol;
+
+  mkl_err = 
+    dss_solve_real(mkl_handle_sp, dss_solve_opt, fR.data, nRhs, fC.data);
+  if(mkl_err != MKL_DSS_SUCCESS) { mkl_death(); }
+  for(sindex i=0; i<n; ++i) { dX.data[i] = fC.data[i]; }
+
+  double last = std::numeric_limits<double>::infinity();
+  for(int k=0; k<max_refine; ++k)
+  {
+    //residual in double precision
+    J.m->multiply(dX.data, rX.data);
+    double rmax{0};
+    for(sindex i=0; i<n; ++i)
+    {
+      rX.data[i] = dS.data[i] - rX.data[i];
+      rmax = std::max(rmax, std::abs(rX.data[i]));
+    }
+    if(rmax <= target) { return true; }
+    if(rmax > 0.5 * last) { break; }
+    last = rmax;
+
+    //correction in single precision
+    for(sindex i=0; i<n; ++i) { fR.data[i] = static_cast<float>(rX.data[i]); }
+    mkl_err = 
+      dss_solve_real(mkl_handle_sp, dss_solve_opt, fR.data, nRhs, fC.data);
+    if(mkl_err != MKL_DSS_SUCCESS) { mkl_death(); }
+    for(sindex i=0; i<n; ++i) { dX.data[i] += fC.data[i]; }
+    ++refine_steps;
+  }
+
+  //refinement stalled, the jacobian is too poorly conditioned for single
+  //precision so stay in double precision for the rest of this run
+  sp_stalled = true;
+  return false;
+}
+
+void PowerFlow::step()
+{
+  solve();
  
   update_state();
-  calc_sCalc();
-  calc_dSch();
-  calc_dS();
-
-  J.update();
+  evaluate();
   
   ++steps;
 }
@@ -148,16 +461,214 @@ double PowerFlow::max_dS()
   return max;
 }
 
-void PowerFlow::run()
+void PowerFlow::newton()
 {
-  steps = 0;
   step();
   while(max_dS() > thresh)
   {
     step();
   }
 }
+
+//Switches generator buses between PV and PQ according to their reactive
+//limits and returns the number of buses that switched. A PV bus whose net
+//reactive injection leaves [qmin, qmax] is pinned at the violated limit, a
+//pinned bus returns to PV once its voltage is back on the controllable side
+//of the generator setpoint. Only values change, the jacobian structure and
+//the symbolic analysis are kept since every limited generator bus already
+//owns a reactive row
+int PowerFlow::switch_q_limits()
+{
+  using std::abs;
+  using std::arg;
+
+  int switched{0};
+  for(size_t i=0; i<G->buses.size(); ++i)
+  {
+    Bus &b = *G->buses[i];
+    if(!b.qRow() || !b.generator) { continue; }
+
+    const Generator &gen = *b.generator;
+    complex &vi = state.data[i];
+    double q = sCalc.data[i].imag(),
+           vset = abs(gen.v(0));
+
+    switch(b.qlim)
+    {
+      case Bus::QLimit::None:
+        if(q > gen.qmax) { b.qlim = Bus::QLimit::Max; }
+        else if(q < gen.qmin) { b.qlim = Bus::QLimit::Min; }
+        else { continue; }
+        sSch.data[i].imag(b.qlim == Bus::QLimit::Max ? gen.qmax : gen.qmin);
+        break;
+
+      case Bus::QLimit::Max:
+        if(abs(vi) <= vset) { continue; }
+        b.qlim = Bus::QLimit::None;
+        vi = polar(vset, arg(vi));
+        break;
+
+      case Bus::QLimit::Min:
+        if(abs(vi) >= vset) { continue; }
+        b.qlim = Bus::QLimit::None;
+        vi = polar(vset, arg(vi));
+        break;
+    }
+    ++switched;
+  }
+  q_switches += switched;
+  if(switched > 0) { J.regroup(); }
+  return switched;
+}
+
+void PowerFlow::run()
+{
+  if(tuner && !tuned)
+  {
+    tuner->tune(*this);
+    tuned = true;
+  }
+
+  steps = 0;
+  refine_steps = 0;
+  q_switches = 0;
+  sp_stalled = false;
+  newton();
+
+  if(!q_limits) { return; }
+  for(int k=0; k<max_q_rounds && switch_q_limits() > 0; ++k)
+  {
+    evaluate(true);
+    newton();
+  }
+}
     
+static const uint32_t checkpoint_version{1};
+
+template <class T>
+static void put(std::ostream &o, T x)
+{
+  o.write(reinterpret_cast<const char*>(&x), sizeof(T));
+}
+
+template <class T>
+static T get(std::istream &in)
+{
+  T x{};
+  in.read(reinterpret_cast<char*>(&x), sizeof(T));
+  return x;
+}
+
+template <class T>
+static void putArray(std::ostream &o, const T *x, size_t n)
+{
+  o.write(reinterpret_cast<const char*>(x), sizeof(T) * n);
+}
+
+template <class T>
+static void getArray(std::istream &in, T *x, size_t n)
+{
+  in.read(reinterpret_cast<char*>(x), sizeof(T) * n);
+}
+
+//Writes the solver state to @path: the bus voltages, the schedule, the
+//injections and mismatches, the last correction, the jacobian values and
+//the reactive limits in force, tagged with the topology of the jacobian.
+//The numeric factors stay behind, the direct solver factors on every solve
+//anyway so a restored solver pays for exactly one factorization
+void PowerFlow::checkpoint(const string &path) const
+{
+  size_t nb = G->buses.size();
+  const SMatrix<double> &m = *J.m;
+  string tmp = path + ".tmp" + std::to_string(getpid());
+  {
+    std::ofstream out(tmp, std::ios::binary);
+    if(!out.good()) {
+      throw std::runtime_error("Unable to write file " + tmp);
+    }
+    out.write("GWCP", 4);
+    put<uint32_t>(out, checkpoint_version);
+    put<uint64_t>(out, J.topology);
+    put<uint64_t>(out, nb);
+    put<int64_t>(out, m.n);
+    put<int64_t>(out, m.s);
+    for(const Bus *b : G->buses) { put<int8_t>(out, int8_t(b->qlim)); }
+    putArray(out, state.data, nb);
+    putArray(out, sSch.data, nb);
+    putArray(out, sCalc.data, nb);
+    putArray(out, dSch.data, nb);
+    putArray(out, dS.data, m.n);
+    putArray(out, dX.data, m.n);
+    putArray(out, m.v, m.s);
+    if(!out.good()) {
+      throw std::runtime_error("Unable to write file " + tmp);
+    }
+  }
+  if(std::rename(tmp.c_str(), path.c_str()) != 0)
+  {
+    std::remove(tmp.c_str());
+    throw std::runtime_error("Unable to write file " + path);
+  }
+}
+
+//Restores a checkpoint taken on the same topology, the next run starts from
+//the checkpointed solution and takes one step if the schedule is unchanged.
+//Returns false, leaving the solver as it was, if @path is missing, damaged
+//or was taken on another topology
+bool PowerFlow::restore(const string &path)
+{
+  std::ifstream in(path, std::ios::binary);
+  if(!in.good()) { return false; }
+
+  size_t nb = G->buses.size();
+  SMatrix<double> &m = *J.m;
+  char magic[4];
+  in.read(magic, 4);
+  if(!in || string(magic, 4) != "GWCP") { return false; }
+  if(get<uint32_t>(in) != checkpoint_version ||
+     get<uint64_t>(in) != J.topology ||
+     get<uint64_t>(in) != nb ||
+     get<int64_t>(in) != m.n ||
+     get<int64_t>(in) != m.s) {
+    return false;
+  }
+
+  vector<int8_t> qlim(nb);
+  getArray(in, qlim.data(), nb);
+  for(size_t i=0; i<nb; ++i)
+  {
+    const Bus &b = *G->buses[i];
+    if(qlim[i] < 0 || qlim[i] > int8_t(Bus::QLimit::Max)) { return false; }
+    if(qlim[i] && (!b.qRow() || !b.generator)) { return false; }
+  }
+
+  vector<complex> v(4*nb);
+  vector<double> d(2*m.n + m.s);
+  getArray(in, v.data(), v.size());
+  getArray(in, d.data(), d.size());
+  if(!in || in.peek() != std::ifstream::traits_type::eof()) { return false; }
+
+  std::copy(v.begin(), v.begin() + nb, state.data);
+  std::copy(v.begin() + nb, v.begin() + 2*nb, sSch.data);
+  std::copy(v.begin() + 2*nb, v.begin() + 3*nb, sCalc.data);
+  std::copy(v.begin() + 3*nb, v.end(), dSch.data);
+  std::copy(d.begin(), d.begin() + m.n, dS.data);
+  std::copy(d.begin() + m.n, d.begin() + 2*m.n, dX.data);
+  std::copy(d.begin() + 2*m.n, d.end(), m.v);
+
+  bool kinds{false};
+  for(size_t i=0; i<nb; ++i)
+  {
+    Bus &b = *G->buses[i];
+    Bus::QLimit q = static_cast<Bus::QLimit>(qlim[i]);
+    kinds = kinds || b.qlim != q;
+    b.qlim = q;
+  }
+  if(kinds) { J.regroup(); }
+  since_full = full_every;
+  return true;
+}
+
 string 
 PowerFlow::result_summary()
 {
@@ -2,6 +2,8 @@
 #define GW_POWERFLOW
 
 #include "Grid.hxx"
+#include "Decomposition.hxx"
+#include "SymbolicCache.hxx"
 #include <mkl_dss.h>
 #include <mkl_types.h>
 #include <cassert>
@@ -10,6 +12,24 @@
 
 namespace gridworks {
 
+  static_assert(sizeof(SMatrix<double>::index) == sizeof(_INTEGER_t),
+      "jacobian indices must match the DSS integer width");
+
+  struct SolverTuner;
+
+  //the knobs of the newton solve that change its speed and not its result,
+  //see PowerFlow::configure and SolverTuner
+  struct SolverConfig
+  {
+    _INTEGER_t reorder{ MKL_DSS_AUTO_ORDER },
+               factor{ MKL_DSS_INDEFINITE };
+    int mkl_threads{0};             //0 leaves MKL threading as it is
+    int kernel_threads{1};          //see Jacobi::threads
+    bool mixed_precision{false};
+
+    std::string toString() const;
+  };
+
   struct PowerFlow
   {
     Grid *G;
@@ -17,11 +37,49 @@ namespace gridworks {
     Glob<complex> state, sSch, sCalc, dSch;
     Jacobi J;
     Glob<double> dX, dS;
+    LoadValues loads;     //the loads of G at state, see calc_sCalc
     int steps{0};
     const double thresh;
+
+    //mixed precision: factor the jacobian in single precision and recover
+    //double precision accuracy with iterative refinement against J.m
+    bool mixed_precision{false};
+    int max_refine{10}, refine_steps{0};
+    double refine_tol{1e-12};
+    bool sp_stalled{false};
+    Glob<float> fJ, fR, fC;
+    Glob<double> rX;
+
+    //domain decomposition solver, used in place of the direct factorization
+    //when set, see decompose
+    std::shared_ptr<DomainSolver> dd;
+
+    //on disk symbolic setup shared between processes, see SymbolicCache
+    SymbolicCache *cache{nullptr};
+
+    //picks the solver configuration on the first run, see SolverTuner
+    SolverTuner *tuner{nullptr};
+    bool tuned{false};
+
+    //incremental evaluation, only the buses whose voltage moved by more than
+    //dirty_tol since they were last evaluated, and their neighbors, are
+    //evaluated again, a moved schedule only refreshes the mismatch of its
+    //bus. Every full_every-th evaluation is a full one, see evaluate
+    bool incremental{false};
+    double dirty_tol{1e-12};
+    int full_every{10}, since_full{0};
+    size_t evaluated{0};
+    Glob<complex> seen, seenSch;
+    vector<char> mark;
+    vector<int> dirty, moved;
+
+    //generator reactive limit enforcement, see switch_q_limits
+    bool q_limits{false};
+    int max_q_rounds{20}, q_switches{0};
    
     //MKL stuff
-    _MKL_DSS_HANDLE_t mkl_handle;
+    _MKL_DSS_HANDLE_t mkl_handle, mkl_handle_sp;
+    bool analyzed{false}, sp_analyzed{false};
     _INTEGER_t nRhs{1}, mkl_err{ MKL_DSS_SUCCESS };
     _INTEGER_t 
       dss_opt{ MKL_DSS_MSG_LVL_INFO + 
@@ -35,20 +93,34 @@ namespace gridworks {
     //---------
 
     PowerFlow(Grid *g, Glob<complex> state, Glob<complex> sSch,
-        double thresh = 0.001);
+        double thresh = 0.001, SymbolicCache *cache = nullptr);
 
     ~PowerFlow();
 
     void calc_sCalc();
     void calc_dSch();
     void calc_dS();
+    void evaluate(bool full = false);
     void update_state();
     void mkl_death();
     void init_mkl();
+    void reset_mkl();
+    void configure(const SolverConfig &c);
+    SolverConfig config() const;
+    void decompose(int k);
+    void analyze();
+    void reorder(_MKL_DSS_HANDLE_t &handle);
+    void analyze_sp();
+    void solve();
+    bool solve_mixed();
     void step();
     double max_dX();
     double max_dS();
+    void newton();
+    int switch_q_limits();
     void run();
+    void checkpoint(const std::string &path) const;
+    bool restore(const std::string &path);
     std::string result_summary();
 
   };
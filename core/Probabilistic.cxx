@@ -0,0 +1,303 @@
+#include "Probabilistic.hxx"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+using namespace gridworks;
+using std::vector;
+using std::runtime_error;
+using std::to_string;
+
+Injection::Injection(int bus, double sigma, double q_ratio, Dist dist)
+  : bus{bus}, sigma{sigma}, q_ratio{q_ratio}, dist{dist} {}
+
+RunningStats::RunningStats(size_t n)
+  : n{n}, mean(n, 0), m2(n, 0),
+    min(n, std::numeric_limits<double>::infinity()),
+    max(n, -std::numeric_limits<double>::infinity()) {}
+
+void RunningStats::add(const double *x)
+{
+  ++count;
+  double w = 1.0 / count;
+  for(size_t i=0; i<n; ++i)
+  {
+    double d = x[i] - mean[i];
+    mean[i] += d * w;
+    m2[i] += d * (x[i] - mean[i]);
+    min[i] = std::min(min[i], x[i]);
+    max[i] = std::max(max[i], x[i]);
+  }
+}
+
+double RunningStats::variance(size_t i) const
+{
+  return count > 1 ? m2[i] / (count - 1) : 0.0;
+}
+
+ProbabilisticFlow::ProbabilisticFlow(PowerFlow *base,
+    vector<Injection> injections, vector<double> corr)
+  : base{base}, injections{injections}, branches{*base->G},
+    rng(seed),
+    vm(base->G->buses.size()), va(base->G->buses.size()),
+    flow(branches.n), loading(branches.n),
+    undervoltage(base->G->buses.size()), overvoltage(base->G->buses.size()),
+    overload(branches.n)
+{
+  Grid &g = *base->G;
+  size_t m = injections.size();
+  for(const Injection &in : injections)
+  {
+    if(in.bus < 0 || static_cast<size_t>(in.bus) >= g.buses.size()) {
+      throw runtime_error("injection at unknown bus " + to_string(in.bus));
+    }
+    if(g.buses[in.bus]->slack) {
+      throw runtime_error("injection at the slack bus " + to_string(in.bus));
+    }
+  }
+
+  if(!corr.empty())
+  {
+    if(corr.size() != m*m) {
+      throw runtime_error("the correlation matrix must be " + to_string(m) +
+          "x" + to_string(m));
+    }
+    L = corr;
+    sindex info = LAPACKE_dpotrf(LAPACK_ROW_MAJOR, 'L', m, L.data(), m);
+    if(info != 0) {
+      throw runtime_error("the correlation matrix is not positive definite");
+    }
+    for(size_t i=0; i<m; ++i) {
+      for(size_t j=i+1; j<m; ++j) { L[i*m+j] = 0; }
+    }
+  }
+
+  //the Sobol generator has 40 dimensions
+  sampling = m <= 40 ? Sampling::Sobol : Sampling::LatinHypercube;
+
+  full.reset(new PowerFlow{base->G, base->state.clone(), base->sSch.clone(),
+                           base->thresh});
+
+  //the linear sensitivity is the jacobian at the base solution
+  if(!base->analyzed) { base->analyze(); }
+  base->mkl_err = dss_factor_real(base->mkl_handle, base->dss_factor_opt,
+                                  base->J.m->v);
+  if(base->mkl_err != MKL_DSS_SUCCESS) { base->mkl_death(); }
+}
+
+ProbabilisticFlow::~ProbabilisticFlow()
+{
+  if(stream) { vslDeleteStream(&stream); }
+}
+
+void ProbabilisticFlow::draw(size_t count, double *dp)
+{
+  size_t m = injections.size(), k = count * m;
+  vector<double> u(k), z(k);
+
+  if(!stream)
+  {
+    int err = sampling == Sampling::Sobol
+      ? vslNewStream(&stream, VSL_BRNG_SOBOL, m)
+      : vslNewStream(&stream, VSL_BRNG_MT19937, seed);
+    if(err != VSL_STATUS_OK) {
+      throw runtime_error("VSL stream failed with error " + to_string(err));
+    }
+  }
+
+  if(sampling == Sampling::Sobol) {
+    vdRngUniform(VSL_RNG_METHOD_UNIFORM_STD, stream, k, u.data(), 0, 1);
+  }
+  else
+  {
+    //one sample in each of the count strata of every dimension
+    vector<int> strata(count);
+    vector<double> r(count);
+    for(size_t j=0; j<m; ++j)
+    {
+      std::iota(strata.begin(), strata.end(), 0);
+      std::shuffle(strata.begin(), strata.end(), rng);
+      vdRngUniform(VSL_RNG_METHOD_UNIFORM_STD, stream, count, r.data(), 0, 1);
+      for(size_t s=0; s<count; ++s) {
+        u[s*m+j] = (strata[s] + r[s]) / count;
+      }
+    }
+  }
+
+  //the first Sobol point sits on the boundary of the unit cube
+  for(double &x : u) { x = std::min(std::max(x, 1e-12), 1 - 1e-12); }
+  vdCdfNormInv(k, u.data(), z.data());
+
+  if(!L.empty())
+  {
+    for(size_t s=0; s<count; ++s)
+    {
+      const double *y = &z[s*m];
+      for(size_t i=0; i<m; ++i)
+      {
+        double c{0};
+        for(size_t j=0; j<=i; ++j) { c += L[i*m+j] * y[j]; }
+        u[s*m+i] = c;
+      }
+    }
+    std::swap(u, z);
+  }
+
+  //back through the normal cdf for the uniform marginals
+  vdCdfNorm(k, z.data(), u.data());
+  for(size_t s=0; s<count; ++s)
+  {
+    for(size_t j=0; j<m; ++j)
+    {
+      const Injection &in = injections[j];
+      size_t i = s*m+j;
+      dp[i] = in.dist == Injection::Dist::Normal
+        ? in.sigma * z[i]
+        : in.sigma * std::sqrt(3.0) * (2*u[i] - 1);
+    }
+  }
+}
+
+bool ProbabilisticFlow::nearLimit(Glob<complex> v, const FlowResults &fr) const
+{
+  const Grid &g = *base->G;
+  double lo = vmin + vmargin, hi = vmax - vmargin, sl = 1 - smargin;
+  for(size_t i=0; i<g.buses.size(); ++i)
+  {
+    const Bus &b = *g.buses[i];
+    if(b.slack || b.vControlled()) { continue; }
+    double a = std::abs(v.data[i]);
+    if(a < lo || a > hi) { return true; }
+  }
+  for(size_t k=0; k<fr.n; ++k) {
+    if(fr.loading.data[k] > sl) { return true; }
+  }
+  return false;
+}
+
+bool ProbabilisticFlow::record(Glob<complex> v, const FlowResults &fr,
+    vector<double> &x)
+{
+  const Grid &g = *base->G;
+  size_t nb = g.buses.size();
+  bool violated{false};
+
+  for(size_t i=0; i<nb; ++i) { x[i] = std::abs(v.data[i]); }
+  vm.add(x.data());
+  for(size_t i=0; i<nb; ++i)
+  {
+    const Bus &b = *g.buses[i];
+    if(b.slack || b.vControlled()) { continue; }
+    if(x[i] < vmin) { ++undervoltage[i]; violated = true; }
+    if(x[i] > vmax) { ++overvoltage[i]; violated = true; }
+  }
+  for(size_t i=0; i<nb; ++i) { x[i] = std::arg(v.data[i]); }
+  va.add(x.data());
+
+  flow.add(fr.p0.data);
+  loading.add(fr.loading.data);
+  for(size_t k : fr.violations) { ++overload[k]; violated = true; }
+
+  return violated;
+}
+
+bool ProbabilisticFlow::solve(const double *dp)
+{
+  PowerFlow &pf = *full;
+  size_t nb = base->G->buses.size();
+  std::copy(base->state.data, base->state.data + nb, pf.state.data);
+  std::copy(base->sSch.data, base->sSch.data + nb, pf.sSch.data);
+  for(size_t j=0; j<injections.size(); ++j)
+  {
+    const Injection &in = injections[j];
+    pf.sSch.data[in.bus] += complex{dp[j], in.q_ratio * dp[j]};
+  }
+
+  pf.calc_sCalc();
+  pf.calc_dSch();
+  pf.calc_dS();
+  pf.J.update();
+  for(int it=0; it<max_newton; ++it)
+  {
+    double mis = pf.max_dS();
+    if(mis < pf.thresh) { return true; }
+    if(!std::isfinite(mis)) { return false; }
+    pf.step();
+  }
+  return pf.max_dS() < pf.thresh;
+}
+
+void ProbabilisticFlow::run(size_t n)
+{
+  const Grid &g = *base->G;
+  size_t m = injections.size(),
+         nb = g.buses.size(),
+         N = base->J.m->n;
+  const complex *v0 = base->state.data;
+
+  vector<double> dp(batch*m), rhs(batch*N), dx(batch*N),
+                 x(std::max(nb, branches.n));
+  Glob<complex> v(nb);
+  FlowResults fr(branches.n);
+
+  for(size_t done=0; done<n; )
+  {
+    size_t count = std::min(batch, n - done);
+    draw(count, dp.data());
+
+    //dS of every sample, one column each
+    std::fill(rhs.begin(), rhs.begin() + count*N, 0.0);
+    for(size_t s=0; s<count; ++s)
+    {
+      double *r = &rhs[s*N];
+      for(size_t j=0; j<m; ++j)
+      {
+        const Injection &in = injections[j];
+        const Bus &b = *g.buses[in.bus];
+        r[b.jidx[0]] += dp[s*m+j];
+        if(b.qRow() && !b.vControlled()) {
+          r[b.jidx[1]] += in.q_ratio * dp[s*m+j];
+        }
+      }
+    }
+
+    _INTEGER_t nrhs = count;
+    base->mkl_err = dss_solve_real(base->mkl_handle, base->dss_solve_opt,
+                                   rhs.data(), nrhs, dx.data());
+    if(base->mkl_err != MKL_DSS_SUCCESS) { base->mkl_death(); }
+
+    for(size_t s=0; s<count; ++s)
+    {
+      //the linear update, as PowerFlow::update_state would apply it
+      const double *d = &dx[s*N];
+      for(size_t i=0; i<nb; ++i)
+      {
+        const Bus &b = *g.buses[i];
+        if(b.slack) { v.data[i] = v0[i]; continue; }
+        double a = std::abs(v0[i]);
+        if(!b.vControlled()) { a += a * d[b.jidx[1]]; }
+        v.data[i] = std::polar(a, std::arg(v0[i]) + d[b.jidx[0]]);
+      }
+      branchFlows(branches, v, fr);
+
+      if(nearLimit(v, fr))
+      {
+        ++full_solves;
+        if(!solve(&dp[s*m]))
+        {
+          ++diverged;
+          ++violations;
+          ++samples;
+          continue;
+        }
+        std::copy(full->state.data, full->state.data + nb, v.data);
+        branchFlows(branches, v, fr);
+      }
+
+      if(record(v, fr, x)) { ++violations; }
+      ++samples;
+    }
+    done += count;
+  }
+}
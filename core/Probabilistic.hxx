@@ -0,0 +1,135 @@
+#ifndef GW_PROBABILISTIC
+#define GW_PROBABILISTIC
+
+#include "PowerFlow.hxx"
+#include "BranchFlow.hxx"
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+namespace gridworks {
+
+/*=============================================================================
+ * An #Injection is an uncertain active power injection at a bus, zero mean
+ * with standard deviation %sigma around the schedule. The reactive injection
+ * follows at a fixed ratio to the active one
+ *===========================================================================*/
+struct Injection {
+  //types ---------------------------------------------------------------------
+  enum class Dist{ Normal, Uniform };
+
+  //data ----------------------------------------------------------------------
+  int     bus;
+  double  sigma;
+  double  q_ratio{0};
+  Dist    dist{Dist::Normal};
+
+  //constructors --------------------------------------------------------------
+  Injection(int bus, double sigma, double q_ratio = 0,
+            Dist dist = Dist::Normal);
+};
+
+/*=============================================================================
+ * #RunningStats accumulates the mean, variance and range of %n quantities
+ * one sample at a time (Welford), nothing is kept per sample
+ *===========================================================================*/
+struct RunningStats {
+  //data ----------------------------------------------------------------------
+  size_t          n{0}, count{0};
+  vector<double>  mean, m2, min, max;
+
+  //constructors --------------------------------------------------------------
+  explicit RunningStats(size_t n);
+
+  //methods -------------------------------------------------------------------
+  //adds one sample of all n quantities
+  void add(const double *x);
+
+  //sample variance of quantity @i
+  double variance(size_t i) const;
+};
+
+/*=============================================================================
+ * The #ProbabilisticFlow runs a Monte Carlo power flow around a converged
+ * base case. The injections are drawn from a Sobol sequence, or per batch
+ * from a Latin hypercube when there are more of them than the Sobol
+ * generator has dimensions, mapped through the inverse normal CDF and
+ * correlated by the Cholesky factor of %corr (a Gaussian copula, uniform
+ * marginals are mapped back through the normal CDF).
+ *
+ * Every sample is first screened with the linear sensitivity of the base
+ * case, the jacobian of the converged base is factored once and a whole
+ * batch of perturbations is solved against that factorization in one multi
+ * right hand side solve. A sample whose linearized voltages or branch
+ * loadings come within %vmargin or %smargin of a limit is solved again with
+ * the full nonlinear power flow, all others keep their linear update. The
+ * voltages and branch flows of every sample stream into running statistics.
+ *
+ * The factorization of the base case power flow is reused, so the base must
+ * not be stepped while the study runs
+ *===========================================================================*/
+struct ProbabilisticFlow {
+  //types ---------------------------------------------------------------------
+  enum class Sampling{ Sobol, LatinHypercube };
+
+  //data ----------------------------------------------------------------------
+  PowerFlow         *base;
+  vector<Injection> injections;
+  vector<double>    L;              //Cholesky factor of the correlations,
+                                    //row major lower, empty if independent
+  BranchArrays      branches;
+  std::unique_ptr<PowerFlow> full;  //nonlinear solver for flagged samples
+
+  Sampling          sampling;       //Sobol when the dimensions allow it
+  unsigned          seed{7};
+  VSLStreamStatePtr stream{nullptr};
+  std::mt19937      rng;            //Latin hypercube strata permutations
+  size_t            batch{256};     //samples per linear solve
+
+  double            vmin{0.95},     //voltage limits, applied to the buses
+                    vmax{1.05},     //without voltage control
+                    vmargin{0.01},  //screening margin on the voltages
+                    smargin{0.05};  //screening margin on the loadings
+  int               max_newton{20};
+
+  RunningStats      vm, va,         //bus voltage magnitude and angle
+                    flow,           //active flow into the b[0] end
+                    loading;        //worst end loading
+  size_t            samples{0},
+                    full_solves{0},
+                    diverged{0},    //full solves that did not converge
+                    violations{0};  //samples with any limit violated
+  vector<size_t>    undervoltage, overvoltage, overload;
+
+  //constructors --------------------------------------------------------------
+  //@base must be converged, @corr is the row major correlation matrix of the
+  //injections or empty if they are independent
+  ProbabilisticFlow(PowerFlow *base, vector<Injection> injections,
+                    vector<double> corr = {});
+  ~ProbabilisticFlow();
+  ProbabilisticFlow(const ProbabilisticFlow &) = delete;
+  ProbabilisticFlow & operator=(const ProbabilisticFlow &) = delete;
+
+  //methods -------------------------------------------------------------------
+  //draws @n more samples
+  void run(size_t n);
+
+  //draws the injection perturbations of @count samples into @dp, one
+  //injection after the other within a sample
+  void draw(size_t count, double *dp);
+
+  //full nonlinear solve at the schedule perturbed by @dp, true on
+  //convergence
+  bool solve(const double *dp);
+
+  //records the voltages @v and their flows, true if a limit is violated
+  bool record(Glob<complex> v, const FlowResults &fr, vector<double> &x);
+
+  //true if a linearized sample needs a full solve
+  bool nearLimit(Glob<complex> v, const FlowResults &fr) const;
+};
+
+}
+
+#endif
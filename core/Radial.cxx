@@ -0,0 +1,182 @@
+#include "Radial.hxx"
+#include <algorithm>
+#include <cmath>
+
+using namespace gridworks;
+using std::vector;
+using std::runtime_error;
+using std::to_string;
+
+RadialSweep::RadialSweep(Grid *g, Glob<complex> sLoad)
+  : G{g}, n{g->buses.size()},
+    parent(n), cbeg(n), cend(n),
+    Z(9*n), Ysh(9*n), tp(n), tc(n),
+    sLoad{sLoad}, s(3*n), v(3*n), i(3*n)
+{
+  auto root = std::find_if(g->buses.begin(), g->buses.end(),
+      [](const Bus *b) { return b->slack; });
+  if(root == g->buses.end()) {
+    throw runtime_error("a radial feeder needs a slack bus at its root");
+  }
+
+  //breadth first, one level at a time
+  vector<Branch*> via{nullptr};
+  node.assign(n, -1);
+  bus.push_back((*root)->id);
+  node[(*root)->id] = 0;
+  parent[0] = -1;
+  level.push_back(0);
+  for(size_t b0=0, e0=1; b0<e0; b0=e0, e0=bus.size())
+  {
+    for(size_t p=b0; p<e0; ++p)
+    {
+      cbeg[p] = bus.size();
+      for(const Neighbor &nb : g->buses[bus[p]]->neighbors)
+      {
+        if(nb.br == via[p]) { continue; }
+        int j = nb.b->id;
+        if(node[j] >= 0) {
+          throw runtime_error("the grid is not radial, bus " +
+              to_string(j) + " closes a loop");
+        }
+        node[j] = bus.size();
+        parent[bus.size()] = p;
+        bus.push_back(j);
+        via.push_back(nb.br);
+      }
+      cend[p] = bus.size();
+    }
+    level.push_back(e0);
+  }
+  if(bus.size() != n) {
+    throw runtime_error("the grid is not connected, " +
+        to_string(n - bus.size()) + " buses are not reachable from the slack");
+  }
+
+  //branch models
+  std::fill(Z.data, Z.data + Z.sz, complex{0,0});
+  std::fill(Ysh.data, Ysh.data + Ysh.sz, complex{0,0});
+  for(size_t p=0; p<n; ++p)
+  {
+    const Bus &b = *g->buses[bus[p]];
+    for(int ph=0; ph<3; ++ph) { Ysh[9*p+4*ph] += b.shunt_y; }
+    tp[p] = tc[p] = 1;
+    if(!via[p]) { continue; }
+
+    Branch &br = *via[p];
+    size_t q = parent[p];
+    if(br.kind == Branch::Kind::Line)
+    {
+      Line &l = static_cast<Line&>(br);
+      ThreePhaseLine *tl = dynamic_cast<ThreePhaseLine*>(&l);
+      for(int k=0; k<9; ++k)
+      {
+        bool diag = k % 4 == 0;
+        complex z = tl ? tl->zabc[k] : (diag ? l.z() : 0.0),
+                y = 0.5 * (tl ? tl->yabc[k] : (diag ? l.cy() : 0.0));
+        Z[9*p+k] = z;
+        Ysh[9*p+k] += y;
+        Ysh[9*q+k] += y;
+      }
+    }
+    else
+    {
+      Transformer &t = static_cast<Transformer&>(br);
+      for(int ph=0; ph<3; ++ph) { Z[9*p+4*ph] = t.z(); }
+      const Bus *hi = br.b[1]->rating > br.b[0]->rating ? br.b[1] : br.b[0];
+      if(hi->id == bus[p]) { tc[p] = t.tr().real(); }
+      else { tp[p] = t.tr().real(); }
+    }
+  }
+
+  //balanced flat start at the source voltage
+  complex vs{1,0};
+  if((*root)->generator) { vs = (*root)->generator->v(0); }
+  for(size_t p=0; p<n; ++p) {
+    for(int ph=0; ph<3; ++ph) {
+      v[3*p+ph] = vs * std::polar(1.0, -2.0*M_PI/3.0 * ph);
+    }
+  }
+}
+
+complex RadialSweep::voltage(int b, int phase) const
+{
+  return v.data[3*node[b]+phase];
+}
+
+void RadialSweep::backward()
+{
+  const complex *sd = s.data, *vd = v.data, *Y = Ysh.data;
+  const int *cb = cbeg.data, *ce = cend.data;
+  const double *tp_ = tp.data, *tc_ = tc.data;
+  complex *id = i.data;
+
+  //deepest level first, a node needs the currents of its children
+  for(size_t l=level.size()-1; l-- > 0; )
+  {
+    long b = level[l], e = level[l+1];
+    #pragma omp parallel for if(e - b > 256)
+    for(long p=b; p<e; ++p)
+    {
+      complex J[3];
+      for(int ph=0; ph<3; ++ph)
+      {
+        J[ph] = std::conj(sd[3*p+ph] / vd[3*p+ph]);
+        for(int k=0; k<3; ++k) { J[ph] += Y[9*p+3*ph+k] * vd[3*p+k]; }
+      }
+      for(int c=cb[p]; c<ce[p]; ++c) {
+        for(int ph=0; ph<3; ++ph) { J[ph] += id[3*c+ph]; }
+      }
+      for(int ph=0; ph<3; ++ph) { id[3*p+ph] = J[ph] * (tc_[p] / tp_[p]); }
+    }
+  }
+
+  source = 0;
+  for(int ph=0; ph<3; ++ph) { source += vd[ph] * std::conj(id[ph]); }
+}
+
+double RadialSweep::forward()
+{
+  const complex *z = Z.data, *id = i.data;
+  const int *par = parent.data;
+  const double *tp_ = tp.data, *tc_ = tc.data;
+  complex *vd = v.data;
+  double d{0};
+
+  //root side first, a node needs the voltage of its parent
+  for(size_t l=1; l+1<level.size(); ++l)
+  {
+    long b = level[l], e = level[l+1];
+    #pragma omp parallel for reduction(max:d) if(e - b > 256)
+    for(long p=b; p<e; ++p)
+    {
+      int q = par[p];
+      complex is[3];
+      for(int ph=0; ph<3; ++ph) { is[ph] = id[3*p+ph] * tp_[p]; }
+      for(int ph=0; ph<3; ++ph)
+      {
+        complex w = vd[3*q+ph] / tp_[p];
+        for(int k=0; k<3; ++k) { w -= z[9*p+3*ph+k] * is[k]; }
+        w *= tc_[p];
+        d = std::max(d, std::abs(w - vd[3*p+ph]));
+        vd[3*p+ph] = w;
+      }
+    }
+  }
+  return d;
+}
+
+bool RadialSweep::run()
+{
+  for(size_t p=0; p<n; ++p) {
+    for(int ph=0; ph<3; ++ph) { s[3*p+ph] = sLoad.data[3*bus[p]+ph]; }
+  }
+
+  for(iterations=1; iterations<=max_iter; ++iterations)
+  {
+    backward();
+    if(forward() < tol) { return true; }
+  }
+  iterations = max_iter;
+  return false;
+}
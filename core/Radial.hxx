@@ -0,0 +1,63 @@
+#ifndef GW_RADIAL
+#define GW_RADIAL
+
+#include "Grid.hxx"
+#include <stdexcept>
+#include <string>
+
+namespace gridworks {
+
+/*=============================================================================
+ * The #RadialSweep solves a three phase unbalanced radial feeder with the
+ * backward/forward sweep. The feeder is ordered breadth first from the slack
+ * bus once, every node keeps the index of its parent and, because the order
+ * is breadth first, its children form one contiguous range. The nodes of one
+ * level are contiguous as well, so each sweep is a linear pass over flat
+ * arrays, level by level, with the nodes of a level processed in parallel.
+ *
+ * Each branch is a 3x3 series impedance with half its shunt admittance at
+ * either end, a #ThreePhaseLine supplies its phase matrices, other lines and
+ * transformers are taken as balanced and uncoupled. A transformer is a wye
+ * grounded ideal ratio on its higher rated side (b[0] when the ratings are
+ * equal) in series with its impedance. Loads are constant power per phase,
+ * 3 entries per bus in %sLoad, and may be changed between runs, the last
+ * solution is the starting point of the next run
+ *===========================================================================*/
+struct RadialSweep {
+  //data ----------------------------------------------------------------------
+  Grid            *G;
+  size_t          n{0};             //number of nodes, one per bus
+  vector<int>     bus, node;        //bus of each node and node of each bus
+  vector<size_t>  level;            //first node of every level, plus the end
+  Glob<int>       parent,           //parent node, -1 for the root
+                  cbeg, cend;       //range of the children of each node
+  Glob<complex>   Z, Ysh;           //series impedance of the branch from the
+                                    //parent and total shunt, 9 per node
+  Glob<double>    tp, tc;           //ideal ratio at the parent and node end
+  Glob<complex>   sLoad,            //phase loads, 3 per bus
+                  s, v, i;          //loads, voltages and parent side branch
+                                    //currents in node order, 3 per node
+
+  double          tol{1e-8};        //largest voltage change at convergence
+  int             max_iter{100}, iterations{0};
+  complex         source{0,0};      //three phase power from the root
+
+  //constructors --------------------------------------------------------------
+  //orders the feeder from the slack bus, throws if it is meshed or not
+  //connected
+  RadialSweep(Grid *g, Glob<complex> sLoad);
+
+  //methods -------------------------------------------------------------------
+  //sweeps until the voltages settle, returns false after max_iter sweeps
+  bool run();
+
+  //voltage of @phase (0, 1, 2) at @bus
+  complex voltage(int bus, int phase) const;
+
+  void backward();
+  double forward();
+};
+
+}
+
+#endif
@@ -0,0 +1,151 @@
+#include "Reduction.hxx"
+#include <map>
+#include <set>
+
+using namespace gridworks;
+using std::map;
+using std::set;
+using std::pair;
+using std::runtime_error;
+using std::to_string;
+
+ReducedGrid
+gridworks::reduce(Grid &g, const vector<int> &retained,
+                  Glob<complex> state, Glob<complex> sSch)
+{
+  size_t n = g.buses.size();
+  SMatrix<complex> Y = ymatrix(g);
+
+  //new index of each retained bus, -1 for external buses
+  vector<int> keep(n, -1);
+  ReducedGrid rg;
+  for(int id : retained) {
+    if(id < 0 || static_cast<size_t>(id) >= n) {
+      throw runtime_error("retained bus " + to_string(id) +
+          " does not exist");
+    }
+    keep[id] = 0;
+  }
+  for(size_t i=0; i<n; ++i) {
+    if(keep[i] < 0) {
+      if(g.buses[i]->slack) {
+        throw runtime_error("slack bus " + to_string(i) +
+            " must be retained");
+      }
+      continue;
+    }
+    keep[i] = rg.bus_map.size();
+    rg.bus_map.push_back(i);
+  }
+
+  //working copy of the admittance rows and the injected currents
+  vector<map<int, complex>> rows(n);
+  vector<complex> I(n);
+  for(size_t i=0; i<n; ++i) {
+    complex acc{0,0};
+    for(sindex k=Y.r[i]; k<Y.r[i+1]; ++k) {
+      rows[i][Y.c[k]] += Y.v[k];
+      acc += Y.v[k] * state.data[Y.c[k]];
+    }
+    I[i] = acc;
+  }
+  vector<complex> I0 = I;
+
+  //eliminate the external buses, lowest current degree first
+  set<pair<size_t, int>> order;
+  for(size_t i=0; i<n; ++i) {
+    if(keep[i] < 0) { order.insert({rows[i].size(), i}); }
+  }
+
+  while(!order.empty()) {
+    int p = order.begin()->second;
+    order.erase(order.begin());
+
+    map<int, complex> &rp = rows[p];
+    complex ypp = rp[p];
+    if(std::abs(ypp) == 0) {
+      throw runtime_error("bus " + to_string(p) +
+          " has no admittance to ground or neighbors");
+    }
+
+    for(const pair<const int, complex> &ej : rp) {
+      int j = ej.first;
+      if(j == p) { continue; }
+
+      map<int, complex> &rj = rows[j];
+      bool external = keep[j] < 0;
+      if(external) { order.erase({rj.size(), j}); }
+
+      complex f = rj[p] / ypp;
+      I[j] -= f * I[p];
+      for(const pair<const int, complex> &ek : rp) {
+        if(ek.first == p) { continue; }
+        rj[ek.first] -= f * ek.second;
+      }
+      rj.erase(p);
+
+      if(external) { order.insert({rj.size(), j}); }
+    }
+    rp.clear();
+  }
+
+  //retained buses with their generators, equivalent shunts and injections
+  size_t m = rg.bus_map.size();
+  rg.sSch = Glob<complex>(m);
+  for(size_t i=0; i<m; ++i) {
+    int o = rg.bus_map[i];
+    const Bus &ob = *g.buses[o];
+    complex vo = state.data[o];
+
+    Bus *b = new Bus(i, ob.rating);
+    b->slack = ob.slack;
+
+    //symmetrized row sum is what is left to ground once the equivalent
+    //branches below take their share of the diagonal
+    complex shunt{0,0};
+    for(const pair<const int, complex> &e : rows[o]) {
+      if(e.first == o) { shunt += e.second; }
+      else { shunt += 0.5 * (e.second + rows[e.first][o]); }
+    }
+    b->shunt_y = shunt;
+
+    if(ob.generator) {
+      const Generator &og = *ob.generator;
+      Generator *gen = new StaticGen(og.v(0));
+      gen->id = og.id;
+      gen->bus_id = i;
+      gen->bus = b;
+      gen->qmin = og.qmin;
+      gen->qmax = og.qmax;
+      b->generator = gen;
+      rg.grid.generators.push_back(gen);
+    }
+
+    //original schedule plus the external current moved onto this bus
+    complex dI = I[o] - I0[o];
+    rg.sSch.data[i] = sSch.data[o] + vo * std::conj(dI);
+
+    rg.grid.buses.push_back(b);
+  }
+
+  //equivalent branches, one per remaining off diagonal pair
+  int lid{0};
+  for(size_t i=0; i<m; ++i) {
+    int o = rg.bus_map[i];
+    for(const pair<const int, complex> &e : rows[o]) {
+      int t = e.first;
+      if(t <= o) { continue; }
+      complex y = -0.5 * (e.second + rows[t][o]);
+      if(std::abs(y) == 0) { continue; }
+
+      Line *l = new SimpleLine(1.0/y);
+      l->id = lid++;
+      l->bus_ids[0] = i;
+      l->bus_ids[1] = keep[t];
+      l->connect(rg.grid.buses[i], rg.grid.buses[keep[t]]);
+      rg.grid.lines.push_back(l);
+    }
+  }
+
+  return rg;
+}
@@ -0,0 +1,38 @@
+#ifndef GW_REDUCTION
+#define GW_REDUCTION
+
+#include "Grid.hxx"
+#include <stdexcept>
+#include <string>
+
+namespace gridworks {
+
+/*=============================================================================
+ * A #ReducedGrid is the Ward equivalent of a #Grid over a set of retained
+ * buses. The external buses are gone, their admittance is folded into
+ * equivalent branches and bus shunts and their injections into the
+ * equivalent schedule %sSch
+ *===========================================================================*/
+struct ReducedGrid {
+  //data ----------------------------------------------------------------------
+  Grid            grid;     //the retained buses and equivalent branches
+  Glob<complex>   sSch;     //scheduled injections of the retained buses
+                            //including the equivalent external injections
+  vector<int>     bus_map;  //original bus id of each bus in %grid
+};
+
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * The $reduce function eliminates every bus of @g that is not listed in
+ * @retained from the admittance matrix of @g with a sparse Schur complement,
+ * eliminating external buses in minimum degree order. The external injections
+ * are taken as the currents implied by the operating point @state and are
+ * moved onto the boundary buses, so the equivalent is exact at @state. @sSch
+ * is the schedule of the full grid, only its retained entries are used. The
+ * slack bus must be retained
+ *~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~*/
+ReducedGrid reduce(Grid &g, const vector<int> &retained,
+                   Glob<complex> state, Glob<complex> sSch);
+
+}
+
+#endif
@@ -0,0 +1,203 @@
+#include "ResultSink.hxx"
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <algorithm>
+#ifdef GW_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+using namespace gridworks;
+using std::string;
+using std::runtime_error;
+
+void ResultSink::append(double t, PowerFlow &pf, const FlowResults *flows)
+{
+  append(t, pf.state, pf.sCalc, flows);
+}
+
+//ColumnarWriter --------------------------------------------------------------
+
+template <class T>
+static void put(vector<char> &b, T x)
+{
+  const char *p = reinterpret_cast<const char*>(&x);
+  b.insert(b.end(), p, p + sizeof(T));
+}
+
+ColumnarWriter::ColumnarWriter(const string &path, size_t nbus,
+                               size_t nbranch, size_t batch, bool compress)
+  : path{path}, out(path, std::ios::binary), nbus{nbus}, nbranch{nbranch},
+    batch{batch}, flows{nbranch > 0}, compress{compress}
+{
+  if(!out.good()) {
+    throw runtime_error("Unable to write file " + path);
+  }
+#ifndef GW_HAVE_ZLIB
+  if(compress) {
+    throw runtime_error("compressed results need a build with zlib");
+  }
+#endif
+  if(batch == 0) {
+    throw runtime_error("a columnar writer needs a batch of at least one");
+  }
+
+  buf.assign(channels() * batch, 0);
+
+  vector<char> h;
+  h.insert(h.end(), {'G','W','C','R'});
+  put<uint32_t>(h, 1);
+  put<uint64_t>(h, nbus);
+  put<uint64_t>(h, nbranch);
+  put<uint8_t>(h, flows);
+  put<uint8_t>(h, compress);
+  out.write(h.data(), h.size());
+  if(!out.good()) {
+    throw runtime_error("Unable to write file " + path);
+  }
+}
+
+//a destructor may not throw, a writer whose last records must be known to
+//have landed calls flush before it goes
+ColumnarWriter::~ColumnarWriter()
+{
+  try { flush(); }
+  catch(...) { }
+}
+
+size_t ColumnarWriter::channels() const
+{
+  return 1 + 4*nbus + 4*nbranch;
+}
+
+void ColumnarWriter::append(double t, Glob<complex> v, Glob<complex> s,
+                            const FlowResults *fr)
+{
+  if(flows && !fr) {
+    throw runtime_error("this writer records flows but none were given");
+  }
+
+  double *col = &buf[rows];
+  col[0] = t;
+  col += batch;
+  for(size_t i=0; i<nbus; ++i) { col[i*batch] = std::abs(v.data[i]); }
+  col += nbus*batch;
+  for(size_t i=0; i<nbus; ++i) { col[i*batch] = std::arg(v.data[i]); }
+  col += nbus*batch;
+  for(size_t i=0; i<nbus; ++i) { col[i*batch] = s.data[i].real(); }
+  col += nbus*batch;
+  for(size_t i=0; i<nbus; ++i) { col[i*batch] = s.data[i].imag(); }
+  col += nbus*batch;
+  if(flows) {
+    const double *src[4] = {fr->p0.data, fr->q0.data, fr->p1.data, fr->q1.data};
+    for(const double *x : src) {
+      for(size_t k=0; k<nbranch; ++k) { col[k*batch] = x[k]; }
+      col += nbranch*batch;
+    }
+  }
+
+  if(++rows == batch) { flush(); }
+}
+
+void ColumnarWriter::flush()
+{
+  if(rows == 0) { return; }
+
+  //the records are gone from the buffer whether or not they land, so that
+  //an error leaves the writer usable
+  size_t n = rows;
+  rows = 0;
+
+  //pack the filled part of every channel back to back
+  size_t nc = channels(),
+         bytes = nc * n * sizeof(double);
+  raw.resize(bytes);
+  for(size_t c=0; c<nc; ++c) {
+    std::memcpy(&raw[c*n*sizeof(double)], &buf[c*batch],
+                n*sizeof(double));
+  }
+
+  uint64_t stored = bytes;
+
+#ifdef GW_HAVE_ZLIB
+  if(compress) {
+    //byte shuffle within each column, then deflate
+    packed.resize(bytes);
+    for(size_t c=0; c<nc; ++c) {
+      const char *src = &raw[c*n*sizeof(double)];
+      char *dst = &packed[c*n*sizeof(double)];
+      for(size_t r=0; r<n; ++r) {
+        for(size_t b=0; b<sizeof(double); ++b) {
+          dst[b*n + r] = src[r*sizeof(double) + b];
+        }
+      }
+    }
+    uLongf len = compressBound(bytes);
+    raw.resize(std::max<size_t>(bytes, len));
+    if(::compress(reinterpret_cast<Bytef*>(raw.data()), &len,
+                  reinterpret_cast<const Bytef*>(packed.data()), bytes)
+        != Z_OK) {
+      throw runtime_error("result compression failed");
+    }
+    stored = len;
+  }
+#endif
+
+  vector<char> h;
+  put<uint32_t>(h, n);
+  put<uint64_t>(h, bytes);
+  put<uint64_t>(h, stored);
+  out.write(h.data(), h.size());
+  out.write(raw.data(), stored);
+  out.flush();
+  if(!out.good()) {
+    throw runtime_error("Unable to write file " + path);
+  }
+}
+
+//CsvSink ---------------------------------------------------------------------
+
+CsvSink::CsvSink(const string &path, size_t nbus, size_t nbranch)
+  : path{path}, out(path), nbus{nbus}, nbranch{nbranch}
+{
+  if(!out.good()) {
+    throw runtime_error("Unable to write file " + path);
+  }
+  out << std::setprecision(11);
+
+  out << "t";
+  for(size_t i=0; i<nbus; ++i) {
+    out << ",vm" << i << ",va" << i << ",p" << i << ",q" << i;
+  }
+  for(size_t k=0; k<nbranch; ++k) {
+    out << ",p0_" << k << ",q0_" << k << ",p1_" << k << ",q1_" << k;
+  }
+  out << '\n';
+}
+
+void CsvSink::append(double t, Glob<complex> v, Glob<complex> s,
+                     const FlowResults *fr)
+{
+  if(nbranch > 0 && !fr) {
+    throw runtime_error("this sink records flows but none were given");
+  }
+
+  out << t;
+  for(size_t i=0; i<nbus; ++i) {
+    out << ',' << std::abs(v.data[i]) << ',' << std::arg(v.data[i])
+        << ',' << s.data[i].real() << ',' << s.data[i].imag();
+  }
+  for(size_t k=0; k<nbranch; ++k) {
+    out << ',' << fr->p0.data[k] << ',' << fr->q0.data[k]
+        << ',' << fr->p1.data[k] << ',' << fr->q1.data[k];
+  }
+  out << '\n';
+}
+
+void CsvSink::flush()
+{
+  out.flush();
+  if(!out.good()) {
+    throw runtime_error("Unable to write file " + path);
+  }
+}
@@ -0,0 +1,91 @@
+#ifndef GW_RESULTSINK
+#define GW_RESULTSINK
+
+#include "PowerFlow.hxx"
+#include "BranchFlow.hxx"
+#include <fstream>
+#include <string>
+#include <stdexcept>
+
+namespace gridworks {
+
+/*=============================================================================
+ * A #ResultSink receives one solution per solve or timestep: the bus
+ * voltages, the bus injections and optionally the branch flows. Concrete
+ * sinks decide how the results are stored
+ *===========================================================================*/
+struct ResultSink {
+  //constructors --------------------------------------------------------------
+  virtual ~ResultSink() = default;
+
+  //methods -------------------------------------------------------------------
+  //appends the solution at time or scenario @t, @flows may be null
+  virtual void append(double t, Glob<complex> v, Glob<complex> s,
+                      const FlowResults *flows) = 0;
+
+  //pushes any buffered results to the underlying storage
+  virtual void flush() = 0;
+
+  //appends the current solution of @pf
+  void append(double t, PowerFlow &pf, const FlowResults *flows = nullptr);
+};
+
+/*=============================================================================
+ * The #ColumnarWriter stores results in a compact binary file. Records are
+ * buffered column by column and written out as one chunk every %batch
+ * records, each chunk holding one contiguous array per channel: time, then
+ * voltage magnitude, voltage angle (radians), P and Q per bus, then P and Q
+ * at both ends of every branch when flows are recorded. Chunks may be
+ * deflated, in which case the bytes of each column are shuffled first so
+ * that the slowly changing exponent bytes sit together
+ *
+ * file   : "GWCR" u32:version u64:buses u64:branches u8:flows u8:compressed
+ * chunk  : u32:records u64:raw bytes u64:stored bytes payload
+ *===========================================================================*/
+struct ColumnarWriter : public ResultSink {
+  //data ----------------------------------------------------------------------
+  std::string       path;
+  std::ofstream     out;
+  size_t            nbus, nbranch, batch, rows{0};
+  bool              flows, compress;
+  vector<double>    buf;      //channel major, %batch slots per channel
+  vector<char>      raw, packed;
+
+  //constructors --------------------------------------------------------------
+  //@nbranch is zero when flows are not recorded, compression needs zlib and
+  //@batch must be at least one. The destructor flushes what is left and
+  //drops any error doing so
+  ColumnarWriter(const std::string &path, size_t nbus, size_t nbranch = 0,
+                 size_t batch = 1024, bool compress = false);
+  ~ColumnarWriter();
+
+  //methods -------------------------------------------------------------------
+  using ResultSink::append;
+  void append(double t, Glob<complex> v, Glob<complex> s,
+              const FlowResults *flows) override;
+  void flush() override;
+  size_t channels() const;
+};
+
+/*=============================================================================
+ * The #CsvSink writes one row per solution, for small cases and inspection
+ *===========================================================================*/
+struct CsvSink : public ResultSink {
+  //data ----------------------------------------------------------------------
+  std::string       path;
+  std::ofstream     out;
+  size_t            nbus, nbranch;
+
+  //constructors --------------------------------------------------------------
+  CsvSink(const std::string &path, size_t nbus, size_t nbranch = 0);
+
+  //methods -------------------------------------------------------------------
+  using ResultSink::append;
+  void append(double t, Glob<complex> v, Glob<complex> s,
+              const FlowResults *flows) override;
+  void flush() override;
+};
+
+}
+
+#endif
@@ -9,23 +9,30 @@
 #include <sstream>
 #include <iostream>
 #include <iomanip>
+#include <vector>
+#include <algorithm>
 
 namespace gridworks
 {
-  template <class T>
+  //I is the index type of the CSR structure, matrices that are handed to the
+  //solver backend must use sindex which matches the MKL interface selected
+  //at build time (32 bit for LP64, 64 bit for ILP64)
+  template <class T, class I = sindex>
   struct SMatrix
   {
-    T         *v;
-    MKL_INT   *c;
-    MKL_INT   *r;
+    using index = I;
 
-    MKL_INT           n, s;
+    T   *v;
+    I   *c;
+    I   *r;
 
-    SMatrix(MKL_INT n, MKL_INT s) : n{n}, s{s}
+    I   n, s;
+
+    SMatrix(I n, I s) : n{n}, s{s}
     {
       v = aalloc<T>(s);
-      c = aalloc<MKL_INT>(s);
-      r = aalloc<MKL_INT>(n+1);
+      c = aalloc<I>(s);
+      r = aalloc<I>(n+1);
 
       memset(v, 0, sizeof(T)*s);
       for(int i=0; i<s; ++i) { c[i] = -1; }
@@ -37,12 +44,12 @@ namespace gridworks
       for(int i=0; i<s; ++i) v[i] = T{};
     }
 
-    T& operator[](std::pair<MKL_INT, MKL_INT> ix)
+    T& operator[](std::pair<I, I> ix)
     {
-      MKL_INT cb = r[ix.first],
-              ce = r[ix.first + 1];
+      I cb = r[ix.first],
+        ce = r[ix.first + 1];
 
-      for(MKL_INT i=cb; i<ce; ++i)
+      for(I i=cb; i<ce; ++i)
       {
         if(c[i] == ix.second) { return v[i]; }
       }
@@ -53,12 +60,58 @@ namespace gridworks
       };
     }
     
-    T at(std::pair<MKL_INT, MKL_INT> ix)
+    //returns a copy with the columns of every row sorted and duplicate
+    //entries merged, the form the solver backend expects
+    SMatrix canonical() const
+    {
+      std::vector<std::pair<I, T>> row;
+      std::vector<I> cs;
+      std::vector<T> vs;
+      std::vector<I> rs(n+1, 0);
+      for(I i=0; i<n; ++i)
+      {
+        row.clear();
+        for(I k=r[i]; k<r[i+1]; ++k) { row.push_back({c[k], v[k]}); }
+        std::sort(row.begin(), row.end(),
+            [](const std::pair<I, T> &a, const std::pair<I, T> &b)
+            { return a.first < b.first; });
+        for(size_t k=0; k<row.size(); ++k)
+        {
+          if(k > 0 && row[k].first == row[k-1].first) 
+          { 
+            vs.back() += row[k].second; 
+            continue; 
+          }
+          cs.push_back(row[k].first);
+          vs.push_back(row[k].second);
+        }
+        rs[i+1] = cs.size();
+      }
+
+      SMatrix m(n, cs.size());
+      std::copy(rs.begin(), rs.end(), m.r);
+      std::copy(cs.begin(), cs.end(), m.c);
+      std::copy(vs.begin(), vs.end(), m.v);
+      return m;
+    }
+
+    //computes y = this * x
+    void multiply(const T *x, T *y) const
+    {
+      for(I i=0; i<n; ++i)
+      {
+        T acc{};
+        for(I k=r[i]; k<r[i+1]; ++k) { acc += v[k] * x[c[k]]; }
+        y[i] = acc;
+      }
+    }
+    
+    T at(std::pair<I, I> ix)
     {
-      MKL_INT cb = r[ix.first],
-              ce = r[ix.first + 1];
+      I cb = r[ix.first],
+        ce = r[ix.first + 1];
 
-      for(MKL_INT i=cb; i<ce; ++i)
+      for(I i=cb; i<ce; ++i)
       {
         if(c[i] == ix.second) { return v[i]; }
       }
@@ -0,0 +1,103 @@
+#include "ShortCircuit.hxx"
+#include <algorithm>
+
+using namespace gridworks;
+using std::vector;
+using std::runtime_error;
+using std::to_string;
+
+ShortCircuit::ShortCircuit(Grid *g, Glob<complex> vpre)
+  : G{g}, vpre{vpre}
+{
+  Y = ymatrix(*g).canonical();
+
+  for(const Generator *gen : g->generators)
+  {
+    if(std::abs(gen->zsub) == 0) { continue; }
+    Y[{gen->bus_id, gen->bus_id}] += 1.0 / gen->zsub;
+  }
+
+  mkl_err = dss_create(mkl_handle, dss_opt);
+  if(mkl_err != MKL_DSS_SUCCESS) { mkl_death(); }
+
+  mkl_err = dss_define_structure(
+      mkl_handle, dss_struct_opt, Y.r, Y.n, Y.n, Y.c, Y.s);
+  if(mkl_err != MKL_DSS_SUCCESS) { mkl_death(); }
+
+  mkl_err = dss_reorder(mkl_handle, dss_reorder_opt, 0);
+  if(mkl_err != MKL_DSS_SUCCESS) { mkl_death(); }
+
+  mkl_err = dss_factor_complex(mkl_handle, dss_factor_opt, Y.v);
+  if(mkl_err != MKL_DSS_SUCCESS) { mkl_death(); }
+}
+
+ShortCircuit::~ShortCircuit()
+{
+  dss_delete(mkl_handle, dss_solve_opt);
+}
+
+void ShortCircuit::mkl_death()
+{
+  throw runtime_error{
+    "MKL has exploded with error: " + to_string(mkl_err)
+  };
+}
+
+void ShortCircuit::column(int bus, complex *z)
+{
+  vector<complex> e(Y.n, complex{0,0});
+  e[bus] = 1.0;
+  _INTEGER_t nrhs{1};
+  mkl_err = dss_solve_complex(mkl_handle, dss_solve_opt, e.data(), nrhs, z);
+  if(mkl_err != MKL_DSS_SUCCESS) { mkl_death(); }
+}
+
+complex ShortCircuit::current(int bus, complex zf)
+{
+  vector<complex> z(Y.n);
+  column(bus, z.data());
+  return vpre.data[bus] / (z[bus] + zf);
+}
+
+complex ShortCircuit::postFault(int bus, complex zf, Glob<complex> &v)
+{
+  vector<complex> z(Y.n);
+  column(bus, z.data());
+  complex If = vpre.data[bus] / (z[bus] + zf);
+  for(sindex i=0; i<Y.n; ++i) { v.data[i] = vpre.data[i] - z[i] * If; }
+  return If;
+}
+
+void ShortCircuit::sweep(complex zf, const Visitor &visit)
+{
+  sindex n = Y.n;
+  vector<complex> e, z;
+
+  for(sindex f0=0; f0<n; f0+=block)
+  {
+    sindex nb = std::min<sindex>(block, n - f0);
+    e.assign(n*nb, complex{0,0});
+    z.resize(n*nb);
+    for(sindex q=0; q<nb; ++q) { e[q*n + f0 + q] = 1.0; }
+
+    _INTEGER_t nrhs = nb;
+    mkl_err =
+      dss_solve_complex(mkl_handle, dss_solve_opt, e.data(), nrhs, z.data());
+    if(mkl_err != MKL_DSS_SUCCESS) { mkl_death(); }
+
+    for(sindex q=0; q<nb; ++q)
+    {
+      sindex f = f0 + q;
+      const complex *zc = &z[q*n];
+      visit(f, vpre.data[f] / (zc[f] + zf), zc);
+    }
+  }
+}
+
+Glob<complex> ShortCircuit::currents(complex zf)
+{
+  Glob<complex> If(Y.n);
+  sweep(zf,
+      [&If](int f, complex i, const complex *) { If.data[f] = i; });
+  return If;
+}
@@ -0,0 +1,73 @@
+#ifndef GW_SHORTCIRCUIT
+#define GW_SHORTCIRCUIT
+
+#include "Grid.hxx"
+#include <mkl_dss.h>
+#include <functional>
+#include <stdexcept>
+#include <string>
+
+namespace gridworks {
+
+/*=============================================================================
+ * The #ShortCircuit engine computes balanced three phase fault currents and
+ * post fault voltages. The admittance matrix of the grid, extended with the
+ * subtransient admittance of every #Generator that has one, is factored once
+ * and the columns of the bus impedance matrix are produced by solves against
+ * that factorization as they are needed, the dense Zbus is never formed.
+ * Loads are neglected
+ *===========================================================================*/
+struct ShortCircuit {
+  //types ---------------------------------------------------------------------
+  //receives the faulted bus, the fault current and the Zbus column of the
+  //faulted bus
+  using Visitor = std::function<void(int, complex, const complex*)>;
+
+  //data ----------------------------------------------------------------------
+  Grid              *G;         //the grid under study
+  SMatrix<complex>  Y{0,0};     //factored admittance matrix
+  Glob<complex>     vpre;       //pre fault bus voltages
+  int               block{32};  //faults solved together in one sweep pass
+
+  _MKL_DSS_HANDLE_t mkl_handle;
+  _INTEGER_t mkl_err{ MKL_DSS_SUCCESS };
+  _INTEGER_t
+    dss_opt{ MKL_DSS_MSG_LVL_WARNING +
+             MKL_DSS_TERM_LVL_ERROR +
+             MKL_DSS_ZERO_BASED_INDEXING
+           },
+    dss_struct_opt{ MKL_DSS_NON_SYMMETRIC_COMPLEX },
+    dss_reorder_opt{ MKL_DSS_AUTO_ORDER },
+    dss_factor_opt{ MKL_DSS_INDEFINITE },
+    dss_solve_opt{ MKL_DSS_DEFAULTS };
+
+  //constructors --------------------------------------------------------------
+  ShortCircuit(Grid *g, Glob<complex> vpre);
+  ~ShortCircuit();
+  ShortCircuit(const ShortCircuit &) = delete;
+  ShortCircuit & operator=(const ShortCircuit &) = delete;
+
+  //methods -------------------------------------------------------------------
+  //computes column @bus of the bus impedance matrix into @z
+  void column(int bus, complex *z);
+
+  //fault current for a fault at @bus through the fault impedance @zf
+  complex current(int bus, complex zf = {0,0});
+
+  //post fault voltages of every bus for a fault at @bus through @zf, returns
+  //the fault current
+  complex postFault(int bus, complex zf, Glob<complex> &v);
+
+  //faults every bus in turn through @zf and hands each result to @visit,
+  //the faults are solved in groups of %block right hand sides
+  void sweep(complex zf, const Visitor &visit);
+
+  //fault current of every bus through @zf
+  Glob<complex> currents(complex zf = {0,0});
+
+  void mkl_death();
+};
+
+}
+
+#endif
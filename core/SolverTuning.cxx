@@ -0,0 +1,220 @@
+#include "SolverTuning.hxx"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <omp.h>
+#include <unistd.h>
+
+using namespace gridworks;
+using std::string;
+using std::runtime_error;
+using std::to_string;
+
+static const int version{1};
+
+string SolverConfig::toString() const
+{
+  std::stringstream ss;
+  ss << "reorder "
+     << (reorder == MKL_DSS_METIS_ORDER ? "metis" :
+         reorder == MKL_DSS_METIS_OPENMP_ORDER ? "metis_openmp" : "auto")
+     << " factor " << factor
+     << " mkl_threads " << mkl_threads
+     << " kernel_threads " << kernel_threads
+     << " mixed_precision " << mixed_precision;
+  return ss.str();
+}
+
+SolverTuner::SolverTuner(string dir) : dir{dir} {}
+
+string SolverTuner::path(uint64_t topology) const
+{
+  std::stringstream ss;
+  ss << dir << "/" << std::hex << std::setw(16) << std::setfill('0')
+     << topology << ".gwtune";
+  return ss.str();
+}
+
+bool SolverTuner::load(uint64_t topology, SolverConfig &c) const
+{
+  std::ifstream in(path(topology));
+  if(!in.good()) { return false; }
+
+  string key;
+  int v{0}, threads{0};
+  SolverConfig r;
+  in >> key >> v;
+  if(!in || key != "gwtune" || v != version) { return false; }
+  while(in >> key)
+  {
+    if(key == "threads") { in >> threads; }
+    else if(key == "reorder") { in >> r.reorder; }
+    else if(key == "factor") { in >> r.factor; }
+    else if(key == "mkl_threads") { in >> r.mkl_threads; }
+    else if(key == "kernel_threads") { in >> r.kernel_threads; }
+    else if(key == "mixed_precision") { in >> r.mixed_precision; }
+    else { return false; }
+  }
+
+  //thread counts tuned on another machine say nothing about this one
+  if(threads != omp_get_max_threads()) { return false; }
+  c = r;
+  return true;
+}
+
+void SolverTuner::store(uint64_t topology, const SolverConfig &c) const
+{
+  string p = path(topology),
+         tmp = p + ".tmp" + to_string(getpid());
+  {
+    std::ofstream out(tmp);
+    if(!out.good()) {
+      throw runtime_error("Unable to write file " + tmp);
+    }
+    out << "gwtune " << version << "\n"
+        << "threads " << omp_get_max_threads() << "\n"
+        << "reorder " << c.reorder << "\n"
+        << "factor " << c.factor << "\n"
+        << "mkl_threads " << c.mkl_threads << "\n"
+        << "kernel_threads " << c.kernel_threads << "\n"
+        << "mixed_precision " << c.mixed_precision << "\n";
+    if(!out.good()) {
+      throw runtime_error("Unable to write file " + tmp);
+    }
+  }
+  if(std::rename(tmp.c_str(), p.c_str()) != 0)
+  {
+    std::remove(tmp.c_str());
+    throw runtime_error("Unable to write file " + p);
+  }
+}
+
+double SolverTuner::measure(PowerFlow &pf, const SolverConfig &c,
+    vector<double> &ref)
+{
+  using clock = std::chrono::steady_clock;
+  auto seconds = [](clock::time_point a, clock::time_point b) {
+    return std::chrono::duration<double>(b - a).count();
+  };
+
+  //every candidate pays for its own analysis, the OpenMP METIS ordering
+  //depends on the thread count, and none replays a cached permutation
+  pf.configure(c);
+  pf.reset_mkl();
+  SymbolicCache *cache = pf.cache;
+  pf.cache = nullptr;
+  clock::time_point t0 = clock::now();
+  pf.analyze();
+  if(pf.mixed_precision) { pf.analyze_sp(); }
+  clock::time_point t1 = clock::now();
+  pf.cache = cache;
+
+  //one untimed step to warm up the factorization and the thread pools
+  pf.J.update();
+  pf.solve();
+  clock::time_point t2 = clock::now();
+  for(int k=0; k<repeats; ++k)
+  {
+    pf.J.update();
+    pf.solve();
+  }
+  clock::time_point t3 = clock::now();
+
+  size_t n = pf.J.m->n;
+  const double *dx = pf.dX.data;
+  if(ref.empty()) { ref.assign(dx, dx + n); }
+  else
+  {
+    double scale{0}, diff{0};
+    for(size_t i=0; i<n; ++i)
+    {
+      scale = std::max(scale, std::abs(ref[i]));
+      diff = std::max(diff, std::abs(dx[i] - ref[i]));
+    }
+    if(!(diff <= tolerance * scale)) {
+      return std::numeric_limits<double>::infinity();
+    }
+  }
+  return seconds(t0, t1) / amortize + seconds(t2, t3) / repeats;
+}
+
+SolverConfig SolverTuner::tune(PowerFlow &pf)
+{
+  SolverConfig best;
+  if(load(pf.J.topology, best))
+  {
+    pf.configure(best);
+    ++reused;
+    return best;
+  }
+
+  //the domain decomposition solver has its own factorization
+  best = pf.config();
+  if(pf.dd) { return best; }
+
+  int hw = omp_get_max_threads();
+  best.mkl_threads = hw;
+  trials.clear();
+  vector<double> ref;
+  double best_time = measure(pf, best, ref);
+  trials.push_back({best, best_time});
+
+  auto axis = [&](const vector<SolverConfig> &cs)
+  {
+    SolverConfig winner = best;
+    for(const SolverConfig &c : cs)
+    {
+      double t = measure(pf, c, ref);
+      trials.push_back({c, t});
+      if(t < best_time)
+      {
+        best_time = t;
+        winner = c;
+      }
+    }
+    best = winner;
+  };
+
+  vector<SolverConfig> cs;
+  for(_INTEGER_t o : {MKL_DSS_AUTO_ORDER, MKL_DSS_METIS_ORDER,
+                      MKL_DSS_METIS_OPENMP_ORDER})
+  {
+    if(o == best.reorder) { continue; }
+    cs.push_back(best);
+    cs.back().reorder = o;
+  }
+  axis(cs);
+
+  cs.clear();
+  for(int t : {1, hw/2})
+  {
+    if(t < 1 || t == best.mkl_threads) { continue; }
+    cs.push_back(best);
+    cs.back().mkl_threads = t;
+  }
+  axis(cs);
+
+  cs.clear();
+  for(int t : {1, hw})
+  {
+    if(t == best.kernel_threads) { continue; }
+    cs.push_back(best);
+    cs.back().kernel_threads = t;
+  }
+  axis(cs);
+
+  cs.assign(1, best);
+  cs.back().mixed_precision = !best.mixed_precision;
+  axis(cs);
+
+  //the handle holds the analysis of the last candidate
+  pf.configure(best);
+  pf.reset_mkl();
+  store(pf.J.topology, best);
+  ++tuned;
+  return best;
+}
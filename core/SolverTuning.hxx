@@ -0,0 +1,56 @@
+#ifndef GW_SOLVERTUNING
+#define GW_SOLVERTUNING
+
+#include "PowerFlow.hxx"
+#include <string>
+#include <utility>
+
+namespace gridworks {
+
+/*=============================================================================
+ * The #SolverTuner picks the #SolverConfig of a power flow by timing it. The
+ * candidates are tried one axis at a time, each axis keeping the winner of
+ * the ones before: the fill reducing ordering (minimum degree, METIS,
+ * OpenMP METIS), the MKL thread count, the threads of the bus kernels and
+ * mixed precision. A trial is one symbolic analysis, weighed in as if it
+ * served %amortize factorizations, plus the average of %repeats jacobian
+ * updates, factorizations and solves. A candidate whose step differs from
+ * the one of the first candidate by more than %tolerance is not taken.
+ *
+ * The winner is kept in %dir, one small text file per $topologyHash and
+ * thread count of the machine, and applied without timing the next time the
+ * topology is seen. Attach a tuner to PowerFlow::tuner to have it applied on
+ * the first run
+ *===========================================================================*/
+struct SolverTuner {
+  //data ----------------------------------------------------------------------
+  std::string     dir;
+  int             repeats{3},
+                  amortize{10};
+  double          tolerance{1e-8};
+  size_t          tuned{0}, reused{0};
+  vector<std::pair<SolverConfig, double>> trials; //of the last tuning,
+                                    //seconds per step, infinite if rejected
+
+  //constructors --------------------------------------------------------------
+  explicit SolverTuner(std::string dir);
+
+  //methods -------------------------------------------------------------------
+  //applies the configuration kept for the topology of @pf, or times the
+  //candidates and keeps the best, and returns it
+  SolverConfig tune(PowerFlow &pf);
+
+  //seconds per newton step of @pf under @c, the step is compared against
+  //@ref, or stored into it when empty
+  double measure(PowerFlow &pf, const SolverConfig &c, vector<double> &ref);
+
+  bool load(uint64_t topology, SolverConfig &c) const;
+  void store(uint64_t topology, const SolverConfig &c) const;
+
+  //the file of the configuration for @topology
+  std::string path(uint64_t topology) const;
+};
+
+}
+
+#endif
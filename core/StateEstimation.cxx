@@ -0,0 +1,296 @@
+#include "StateEstimation.hxx"
+#include <algorithm>
+
+using namespace gridworks;
+using std::runtime_error;
+using std::to_string;
+
+Measurement::Measurement(Kind kind, int bus, double value, double sigma,
+                         Branch *branch)
+  : kind{kind}, bus{bus}, branch{branch}, value{value}, sigma{sigma} {}
+
+//the bus at the far end of the metered branch of flow measurement @m
+static int farEnd(const Measurement &m)
+{
+  return m.branch->b[0]->id == m.bus ? m.branch->b[1]->id
+                                     : m.branch->b[0]->id;
+}
+
+StateEstimator::StateEstimator(Grid *g, vector<Measurement> z)
+  : G{g}, z{z}
+{
+  Y = ymatrix(*g).canonical();
+  x = g->flatStart();
+
+  //state vector: angles of the non slack buses then all magnitudes
+  size_t nb = g->buses.size();
+  sindex nx{0};
+  ai.assign(nb, -1);
+  mi.assign(nb, -1);
+  for(size_t i=0; i<nb; ++i) { if(!g->buses[i]->slack) { ai[i] = nx++; } }
+  for(size_t i=0; i<nb; ++i) { mi[i] = nx++; }
+
+  //the state columns each measurement depends on, in the order evaluate()
+  //produces their partials
+  vector<sindex> cols;
+  vector<sindex> hrow{0};
+  pis.resize(z.size());
+  for(size_t r=0; r<z.size(); ++r)
+  {
+    const Measurement &m = z[r];
+    int i = m.bus;
+    hoff.push_back(cols.size());
+    switch(m.kind)
+    {
+      case Measurement::Kind::V:
+        cols.push_back(mi[i]);
+        break;
+
+      case Measurement::Kind::P:
+      case Measurement::Kind::Q:
+        cols.push_back(ai[i]);
+        cols.push_back(mi[i]);
+        for(sindex k=Y.r[i]; k<Y.r[i+1]; ++k)
+        {
+          if(Y.c[k] == i) { continue; }
+          cols.push_back(ai[Y.c[k]]);
+          cols.push_back(mi[Y.c[k]]);
+        }
+        break;
+
+      case Measurement::Kind::Pf:
+      case Measurement::Kind::Qf:
+      {
+        Branch *br = m.branch;
+        if(!br || (br->b[0]->id != i && br->b[1]->id != i)) {
+          throw runtime_error("flow measurement " + to_string(r) +
+              " is not metered at an end of its branch");
+        }
+        PiModel p = piModel(*br);
+        pis[r] = br->b[0]->id == i ? p : PiModel{p.y11, p.y10, p.y01, p.y00};
+        int j = farEnd(m);
+        cols.push_back(ai[i]);
+        cols.push_back(mi[i]);
+        cols.push_back(ai[j]);
+        cols.push_back(mi[j]);
+        break;
+      }
+    }
+    sindex used{0};
+    for(size_t t=hoff[r]; t<cols.size(); ++t) { if(cols[t] >= 0) { ++used; } }
+    hrow.push_back(hrow.back() + used);
+  }
+  hoff.push_back(cols.size());
+
+  //measurement jacobean, terms that refer to the slack angle have no slot
+  H = SMatrix<double>(z.size(), hrow.back());
+  std::copy(hrow.begin(), hrow.end(), H.r);
+  hpos.assign(cols.size(), -1);
+  sindex e{0};
+  for(size_t t=0; t<cols.size(); ++t)
+  {
+    if(cols[t] < 0) { continue; }
+    H.c[e] = cols[t];
+    hpos[t] = e++;
+  }
+
+  //gain matrix pattern, upper triangle of H'H plus the full diagonal
+  vector<vector<sindex>> grows(nx);
+  for(sindex c=0; c<nx; ++c) { grows[c].push_back(c); }
+  for(size_t r=0; r<z.size(); ++r)
+  {
+    for(sindex p=H.r[r]; p<H.r[r+1]; ++p) {
+      for(sindex q=p+1; q<H.r[r+1]; ++q) {
+        sindex a = std::min(H.c[p], H.c[q]), b = std::max(H.c[p], H.c[q]);
+        grows[a].push_back(b);
+      }
+    }
+  }
+  vector<sindex> grow{0}, gcol;
+  for(vector<sindex> &gr : grows)
+  {
+    std::sort(gr.begin(), gr.end());
+    gr.erase(std::unique(gr.begin(), gr.end()), gr.end());
+    gcol.insert(gcol.end(), gr.begin(), gr.end());
+    grow.push_back(gcol.size());
+  }
+  Gm = SMatrix<double>(nx, gcol.size());
+  std::copy(grow.begin(), grow.end(), Gm.r);
+  std::copy(gcol.begin(), gcol.end(), Gm.c);
+
+  //gain slot fed by each pair of entries in a row of H
+  for(size_t r=0; r<z.size(); ++r)
+  {
+    goff.push_back(gpair.size());
+    for(sindex p=H.r[r]; p<H.r[r+1]; ++p) {
+      for(sindex q=p; q<H.r[r+1]; ++q) {
+        sindex a = std::min(H.c[p], H.c[q]), b = std::max(H.c[p], H.c[q]);
+        sindex slot =
+          std::lower_bound(Gm.c + Gm.r[a], Gm.c + Gm.r[a+1], b) - Gm.c;
+        gpair.push_back(p);
+        gpair.push_back(q);
+        gpair.push_back(slot);
+      }
+    }
+  }
+  goff.push_back(gpair.size());
+
+  h.assign(z.size(), 0);
+  rhs.assign(nx, 0);
+  dx.assign(nx, 0);
+}
+
+StateEstimator::~StateEstimator()
+{
+  if(analyzed) { dss_delete(mkl_handle, dss_solve_opt); }
+}
+
+void StateEstimator::mkl_death()
+{
+  throw runtime_error{
+    "MKL has exploded with error: " + to_string(mkl_err)
+  };
+}
+
+void StateEstimator::evaluate()
+{
+  auto set =
+  [this](sindex pos, double v) { if(pos >= 0) { H.v[pos] = v; } };
+
+  for(size_t r=0; r<z.size(); ++r)
+  {
+    const Measurement &m = z[r];
+    const sindex *pos = &hpos[hoff[r]];
+    int i = m.bus;
+    complex vi = x.data[i];
+    double vi2 = std::norm(vi);
+
+    switch(m.kind)
+    {
+      case Measurement::Kind::V:
+        h[r] = std::abs(vi);
+        set(pos[0], std::abs(vi));
+        break;
+
+      //same partials as Jacobi::update
+      case Measurement::Kind::P:
+      case Measurement::Kind::Q:
+      {
+        bool p = m.kind == Measurement::Kind::P;
+        complex yii = Y.at({i,i});
+        double P = vi2 * yii.real(),
+               Q = -vi2 * yii.imag(),
+               dA{0},
+               dM = p ? 2.0 * vi2 * yii.real() : -2.0 * vi2 * yii.imag();
+        size_t t{2};
+        for(sindex k=Y.r[i]; k<Y.r[i+1]; ++k)
+        {
+          if(Y.c[k] == i) { continue; }
+          Partials d = partials(vi, x.data[Y.c[k]], Y.v[k]);
+          P += d.dPdM;
+          Q += d.dQdM;
+          if(p) {
+            dA += d.dPdA;
+            dM += d.dPdM;
+            set(pos[t], -d.dPdA);
+            set(pos[t+1], d.dPdM);
+          }
+          else {
+            dA -= d.dQdA;
+            dM += d.dQdM;
+            set(pos[t], d.dQdA);
+            set(pos[t+1], d.dQdM);
+          }
+          t += 2;
+        }
+        set(pos[0], dA);
+        set(pos[1], dM);
+        h[r] = p ? P : Q;
+        break;
+      }
+
+      case Measurement::Kind::Pf:
+      case Measurement::Kind::Qf:
+      {
+        const PiModel &pi = pis[r];
+        Partials d = partials(vi, x.data[farEnd(m)], pi.y01);
+        if(m.kind == Measurement::Kind::Pf) {
+          h[r] = vi2 * pi.y00.real() + d.dPdM;
+          set(pos[0], d.dPdA);
+          set(pos[1], 2.0 * vi2 * pi.y00.real() + d.dPdM);
+          set(pos[2], -d.dPdA);
+          set(pos[3], d.dPdM);
+        }
+        else {
+          h[r] = -vi2 * pi.y00.imag() + d.dQdM;
+          set(pos[0], -d.dQdA);
+          set(pos[1], -2.0 * vi2 * pi.y00.imag() + d.dQdM);
+          set(pos[2], d.dQdA);
+          set(pos[3], d.dQdM);
+        }
+        break;
+      }
+    }
+  }
+}
+
+int StateEstimator::estimate()
+{
+  if(!analyzed)
+  {
+    mkl_err = dss_create(mkl_handle, dss_opt);
+    if(mkl_err != MKL_DSS_SUCCESS) { mkl_death(); }
+    analyzed = true;
+
+    mkl_err = dss_define_structure(
+        mkl_handle, dss_struct_opt, Gm.r, Gm.n, Gm.n, Gm.c, Gm.s);
+    if(mkl_err != MKL_DSS_SUCCESS) { mkl_death(); }
+
+    mkl_err = dss_reorder(mkl_handle, dss_reorder_opt, 0);
+    if(mkl_err != MKL_DSS_SUCCESS) { mkl_death(); }
+  }
+
+  _INTEGER_t nrhs{1};
+  for(iterations=0; iterations<max_iter; )
+  {
+    evaluate();
+
+    //normal equations H'WH dx = H'W(z - h)
+    Gm.zero();
+    std::fill(rhs.begin(), rhs.end(), 0.0);
+    objective = 0;
+    for(size_t r=0; r<z.size(); ++r)
+    {
+      double w = 1.0 / (z[r].sigma * z[r].sigma),
+             res = z[r].value - h[r];
+      objective += w * res * res;
+      for(sindex k=H.r[r]; k<H.r[r+1]; ++k) { rhs[H.c[k]] += w*res*H.v[k]; }
+      for(sindex k=goff[r]; k<goff[r+1]; k+=3) {
+        Gm.v[gpair[k+2]] += w * H.v[gpair[k]] * H.v[gpair[k+1]];
+      }
+    }
+
+    mkl_err = dss_factor_real(mkl_handle, dss_factor_opt, Gm.v);
+    if(mkl_err != MKL_DSS_SUCCESS) {
+      throw runtime_error("gain matrix is singular, the measurement set "
+          "does not make the grid observable");
+    }
+    mkl_err =
+      dss_solve_real(mkl_handle, dss_solve_opt, rhs.data(), nrhs, dx.data());
+    if(mkl_err != MKL_DSS_SUCCESS) { mkl_death(); }
+
+    double max{0};
+    for(size_t i=0; i<G->buses.size(); ++i)
+    {
+      complex &v = x.data[i];
+      double da = ai[i] < 0 ? 0.0 : dx[ai[i]],
+             dm = dx[mi[i]];
+      v = std::polar(std::abs(v) * (1.0 + dm), std::arg(v) + da);
+      max = std::max(max, std::max(std::abs(da), std::abs(dm)));
+    }
+    ++iterations;
+    if(max < tol) { break; }
+  }
+
+  return iterations;
+}
@@ -0,0 +1,92 @@
+#ifndef GW_STATEESTIMATION
+#define GW_STATEESTIMATION
+
+#include "Grid.hxx"
+#include <mkl_dss.h>
+#include <stdexcept>
+#include <string>
+
+namespace gridworks {
+
+/*=============================================================================
+ * A #Measurement is a single telemetered quantity, flows are measured at the
+ * %bus end of %branch
+ *===========================================================================*/
+struct Measurement {
+  //types ---------------------------------------------------------------------
+  enum class Kind{ V, P, Q, Pf, Qf };
+
+  //data ----------------------------------------------------------------------
+  Kind      kind;               //what is measured
+  int       bus;                //measured bus, or metered end of %branch
+  Branch    *branch{nullptr};   //measured branch for flow measurements
+  double    value,              //measured value, per unit
+            sigma;              //standard deviation of the meter
+
+  //constructors --------------------------------------------------------------
+  Measurement(Kind kind, int bus, double value, double sigma,
+              Branch *branch = nullptr);
+};
+
+/*=============================================================================
+ * The #StateEstimator is a weighted least squares estimator of the bus
+ * voltages from a set of #Measurement objects. The measurement jacobean H and
+ * the gain matrix H'WH are sparse with a structure, and a fill reducing
+ * ordering, that is computed once for a measurement set. Every iteration only
+ * refreshes values in preallocated storage. The estimate %x is kept between
+ * calls so each scan starts from the previous estimate
+ *===========================================================================*/
+struct StateEstimator {
+  //data ----------------------------------------------------------------------
+  Grid                *G;       //grid being estimated
+  SMatrix<complex>    Y{0,0};   //admittance matrix, canonical form
+  vector<Measurement> z;        //measurement set, values may change per scan
+  Glob<complex>       x;        //current estimate of the bus voltages
+  vector<sindex>      ai,       //state index of each bus angle, -1 for slack
+                      mi;       //state index of each bus magnitude
+  SMatrix<double>     H{0,0};   //measurement jacobean
+  vector<sindex>      hpos,     //H value slot of each term of a measurement
+                      hoff;     //offset of each measurement into %hpos
+  vector<PiModel>     pis;      //metered end two port of flow measurements
+  SMatrix<double>     Gm{0,0};  //gain matrix, upper triangle
+  vector<sindex>      gpair,    //H slot pairs and the gain slot they feed
+                      goff;     //offset of each measurement into %gpair
+  vector<double>      h, rhs, dx;
+  double              tol{1e-6},
+                      objective{0}; //weighted residual sum of squares
+  int                 max_iter{20},
+                      iterations{0};
+
+  _MKL_DSS_HANDLE_t mkl_handle;
+  bool analyzed{false};
+  _INTEGER_t mkl_err{ MKL_DSS_SUCCESS };
+  _INTEGER_t
+    dss_opt{ MKL_DSS_MSG_LVL_WARNING +
+             MKL_DSS_TERM_LVL_ERROR +
+             MKL_DSS_ZERO_BASED_INDEXING
+           },
+    dss_struct_opt{ MKL_DSS_SYMMETRIC },
+    dss_reorder_opt{ MKL_DSS_AUTO_ORDER },
+    dss_factor_opt{ MKL_DSS_POSITIVE_DEFINITE },
+    dss_solve_opt{ MKL_DSS_DEFAULTS };
+
+  //constructors --------------------------------------------------------------
+  StateEstimator(Grid *g, vector<Measurement> z);
+  ~StateEstimator();
+  StateEstimator(const StateEstimator &) = delete;
+  StateEstimator & operator=(const StateEstimator &) = delete;
+
+  //methods -------------------------------------------------------------------
+  //runs Gauss-Newton iterations from the current estimate until the largest
+  //state correction is below %tol, returns the number of iterations
+  int estimate();
+
+  //evaluates h(x) and H(x) at the current estimate
+  void evaluate();
+
+  void mkl_death();
+};
+
+}
+
+#endif
@@ -0,0 +1,351 @@
+#include "Study.hxx"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace gridworks;
+using std::string;
+using std::runtime_error;
+using std::to_string;
+
+//LocalTransport --------------------------------------------------------------
+
+static bool sendAll(int fd, const char *p, size_t n)
+{
+  while(n > 0)
+  {
+    ssize_t k = ::send(fd, p, n, MSG_NOSIGNAL);
+    if(k < 0 && errno == EINTR) { continue; }
+    if(k <= 0) { return false; }
+    p += k;
+    n -= k;
+  }
+  return true;
+}
+
+static bool recvAll(int fd, char *p, size_t n)
+{
+  while(n > 0)
+  {
+    ssize_t k = ::recv(fd, p, n, 0);
+    if(k < 0 && errno == EINTR) { continue; }
+    if(k <= 0) { return false; }
+    p += k;
+    n -= k;
+  }
+  return true;
+}
+
+//frame : i64:scenario u64:bytes payload
+static bool sendMessage(int fd, const Message &m)
+{
+  uint64_t n = m.data.size();
+  char h[16];
+  memcpy(h, &m.scenario, 8);
+  memcpy(h + 8, &n, 8);
+  return sendAll(fd, h, 16) && sendAll(fd, m.data.data(), n);
+}
+
+static bool recvMessage(int fd, Message &m)
+{
+  char h[16];
+  uint64_t n;
+  if(!recvAll(fd, h, 16)) { return false; }
+  memcpy(&m.scenario, h, 8);
+  memcpy(&n, h + 8, 8);
+  m.data.resize(n);
+  return recvAll(fd, m.data.data(), n);
+}
+
+LocalTransport::LocalTransport(size_t workers)
+{
+  //buffered output would be written once by every process
+  std::cout.flush();
+  std::cerr.flush();
+  fflush(nullptr);
+
+  for(size_t k=0; k<workers; ++k)
+  {
+    int sv[2];
+    if(socketpair(AF_UNIX, SOCK_STREAM, 0, sv) != 0) {
+      throw runtime_error("socketpair failed: " + string(strerror(errno)));
+    }
+    pid_t pid = fork();
+    if(pid < 0) {
+      throw runtime_error("fork failed: " + string(strerror(errno)));
+    }
+    if(pid == 0)
+    {
+      close(sv[0]);
+      for(int f : fds) { close(f); }
+      fds.clear();
+      pids.clear();
+      fd = sv[1];
+      return;
+    }
+    close(sv[1]);
+    fds.push_back(sv[0]);
+    pids.push_back(pid);
+  }
+}
+
+LocalTransport::~LocalTransport()
+{
+  for(int f : fds) { if(f >= 0) { close(f); } }
+  for(int pid : pids) { waitpid(pid, nullptr, 0); }
+}
+
+void LocalTransport::send(size_t worker, const Message &m)
+{
+  int f = coordinator() ? fds[worker] : fd;
+  if(f < 0) { return; }
+  if(!sendMessage(f, m) && !coordinator())
+  {
+    //the coordinator is gone, there is nobody left to work for
+    _exit(1);
+  }
+  //a failed send to a worker shows up as Lost on its next receive
+}
+
+size_t LocalTransport::receive(Message &m)
+{
+  if(!coordinator())
+  {
+    if(!recvMessage(fd, m)) { m.scenario = Message::Stop; }
+    return 0;
+  }
+
+  size_t n = fds.size();
+  vector<pollfd> pfd(n);
+  for(size_t k=0; k<n; ++k) { pfd[k] = {fds[k], POLLIN, 0}; }
+  while(true)
+  {
+    if(std::all_of(fds.begin(), fds.end(), [](int f) { return f < 0; })) {
+      throw runtime_error("all workers have gone away");
+    }
+    int r = poll(pfd.data(), n, -1);
+    if(r < 0 && errno == EINTR) { continue; }
+    if(r < 0) {
+      throw runtime_error("poll failed: " + string(strerror(errno)));
+    }
+
+    //start after the worker served last so that none of them starves
+    for(size_t i=1; i<=n; ++i)
+    {
+      size_t k = (last + i) % n;
+      if(fds[k] < 0 || !pfd[k].revents) { continue; }
+      last = k;
+      if(!recvMessage(fds[k], m))
+      {
+        close(fds[k]);
+        fds[k] = pfd[k].fd = -1;
+        m.scenario = Message::Lost;
+        m.data.clear();
+      }
+      return k;
+    }
+  }
+}
+
+void LocalTransport::finish()
+{
+  close(fd);
+  _exit(0);
+}
+
+//MpiTransport ----------------------------------------------------------------
+
+#ifdef GW_WITH_MPI
+MpiTransport::MpiTransport(MPI_Comm comm) : comm{comm}
+{
+  MPI_Comm_rank(comm, &rank);
+  MPI_Comm_size(comm, &size);
+}
+
+void MpiTransport::send(size_t worker, const Message &m)
+{
+  buf.resize(8 + m.data.size());
+  memcpy(buf.data(), &m.scenario, 8);
+  std::copy(m.data.begin(), m.data.end(), buf.begin() + 8);
+  int dest = coordinator() ? worker + 1 : 0;
+  MPI_Send(buf.data(), buf.size(), MPI_BYTE, dest, 0, comm);
+}
+
+size_t MpiTransport::receive(Message &m)
+{
+  MPI_Status st;
+  int count;
+  MPI_Probe(coordinator() ? MPI_ANY_SOURCE : 0, 0, comm, &st);
+  MPI_Get_count(&st, MPI_BYTE, &count);
+  buf.resize(count);
+  MPI_Recv(buf.data(), count, MPI_BYTE, st.MPI_SOURCE, 0, comm,
+           MPI_STATUS_IGNORE);
+  memcpy(&m.scenario, buf.data(), 8);
+  m.data.assign(buf.begin() + 8, buf.end());
+  return coordinator() ? st.MPI_SOURCE - 1 : 0;
+}
+#endif
+
+//StudyCoordinator ------------------------------------------------------------
+
+StudyCoordinator::StudyCoordinator(Transport &transport)
+  : transport(transport) {}
+
+void StudyCoordinator::run(size_t n, const Work &work, const Merge &merge)
+{
+  if(transport.coordinator()) { coordinate(n, merge); }
+  else { serve(work); }
+}
+
+void StudyCoordinator::coordinate(size_t n, const Merge &merge)
+{
+  size_t nw = transport.workers();
+  if(nw == 0 && n > 0) {
+    throw runtime_error("a study needs at least one worker");
+  }
+
+  completed = reassigned = 0;
+  done.assign(nw, 0);
+  vector<std::deque<size_t>> queued(nw);
+  vector<bool> alive(nw, true);
+  std::deque<size_t> pending;             //scenarios of lost workers
+  size_t next{0};
+
+  //keeps the queue of worker @w full
+  auto feed = [&](size_t w)
+  {
+    while(queued[w].size() < depth && (!pending.empty() || next < n))
+    {
+      size_t s;
+      if(!pending.empty()) { s = pending.front(); pending.pop_front(); }
+      else { s = next++; }
+      queued[w].push_back(s);
+      Message m;
+      m.scenario = s;
+      transport.send(w, m);
+    }
+  };
+
+  auto stop = [&]()
+  {
+    Message m;
+    m.scenario = Message::Stop;
+    for(size_t w=0; w<nw; ++w) { if(alive[w]) { transport.send(w, m); } }
+  };
+
+  //results that arrived ahead of their turn when ordered
+  std::map<size_t, vector<char>> held;
+  size_t emit{0};
+
+  Message m;
+  while(completed < n)
+  {
+    size_t w = transport.receive(m);
+    switch(m.scenario)
+    {
+      case Message::Ready:
+        feed(w);
+        continue;
+
+      case Message::Lost:
+        alive[w] = false;
+        reassigned += queued[w].size();
+        pending.insert(pending.end(), queued[w].begin(), queued[w].end());
+        queued[w].clear();
+        for(size_t k=0; k<nw; ++k) { if(alive[k]) { feed(k); } }
+        continue;
+
+      case Message::Failed:
+        stop();
+        throw runtime_error(string(m.data.begin(), m.data.end()));
+    }
+
+    size_t s = m.scenario;
+    auto q = std::find(queued[w].begin(), queued[w].end(), s);
+    if(q == queued[w].end()) { continue; }
+    queued[w].erase(q);
+    ++done[w];
+    ++completed;
+
+    if(!ordered) { merge(s, m.data); }
+    else
+    {
+      held[s] = std::move(m.data);
+      for(auto h=held.begin(); h!=held.end() && h->first==emit; ++emit)
+      {
+        merge(h->first, h->second);
+        h = held.erase(h);
+      }
+    }
+    feed(w);
+  }
+  stop();
+}
+
+void StudyCoordinator::serve(const Work &work)
+{
+  Message m;
+  m.scenario = Message::Ready;
+  transport.send(0, m);
+
+  while(true)
+  {
+    transport.receive(m);
+    if(m.scenario < 0) { break; }
+
+    Message r;
+    r.scenario = m.scenario;
+    try { r.data = work(m.scenario); }
+    catch(const std::exception &e)
+    {
+      string what = "scenario " + to_string(m.scenario) + " failed: " +
+                    e.what();
+      r.scenario = Message::Failed;
+      r.data.assign(what.begin(), what.end());
+    }
+    transport.send(0, r);
+  }
+  transport.finish();
+}
+
+//MappedFile ------------------------------------------------------------------
+
+MappedFile::MappedFile(const string &path)
+{
+  int fd = open(path.c_str(), O_RDONLY);
+  if(fd < 0) {
+    throw runtime_error("Unable to read file " + path);
+  }
+  struct stat st;
+  if(fstat(fd, &st) != 0)
+  {
+    close(fd);
+    throw runtime_error("Unable to read file " + path);
+  }
+  size = st.st_size;
+  if(size > 0)
+  {
+    void *p = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    if(p == MAP_FAILED)
+    {
+      close(fd);
+      throw runtime_error("Unable to map file " + path);
+    }
+    data = static_cast<const char*>(p);
+  }
+  close(fd);
+}
+
+MappedFile::~MappedFile()
+{
+  if(data) { munmap(const_cast<char*>(data), size); }
+}
@@ -0,0 +1,166 @@
+#ifndef GW_STUDY
+#define GW_STUDY
+
+#include "Grid.hxx"
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <stdexcept>
+#include <string>
+#ifdef GW_WITH_MPI
+#include <mpi.h>
+#endif
+
+namespace gridworks {
+
+/*=============================================================================
+ * A #Message carries one scenario between the coordinator and a worker, a
+ * task has an empty payload and a result carries whatever the worker
+ * produced for the scenario. Negative scenarios are control messages, a
+ * failed scenario carries the error text
+ *===========================================================================*/
+struct Message {
+  //types ---------------------------------------------------------------------
+  enum : int64_t { Ready = -1, Stop = -2, Failed = -3, Lost = -4 };
+
+  //data ----------------------------------------------------------------------
+  int64_t       scenario{Ready};
+  vector<char>  data;
+};
+
+/*=============================================================================
+ * A #Transport connects one coordinator to a pool of workers, each process
+ * sees either the coordinator side or the side of one worker
+ *===========================================================================*/
+struct Transport {
+  //constructors --------------------------------------------------------------
+  virtual ~Transport() = default;
+
+  //methods -------------------------------------------------------------------
+  virtual bool coordinator() const = 0;
+  virtual size_t workers() const = 0;
+
+  //on the coordinator, sends @m to @worker, on a worker @worker is ignored and
+  //@m goes to the coordinator
+  virtual void send(size_t worker, const Message &m) = 0;
+
+  //on the coordinator, receives the next message of any worker and returns
+  //that worker, a worker that has gone away sends Lost, on a worker receives
+  //the next message of the coordinator
+  virtual size_t receive(Message &m) = 0;
+
+  //called by a worker once it has been stopped
+  virtual void finish() {}
+};
+
+/*=============================================================================
+ * The #LocalTransport forks a pool of worker processes on this machine, each
+ * connected to the coordinator by a Unix socket pair. The workers are forked
+ * by the constructor and share the memory of the coordinator copy on write,
+ * so a model loaded before the transport is created is loaded once for all
+ * of them. A worker exits from finish, it never returns into the code that
+ * created the transport. Create the transport before the first OpenMP
+ * parallel region, a thread pool does not survive the fork
+ *===========================================================================*/
+struct LocalTransport : public Transport {
+  //data ----------------------------------------------------------------------
+  vector<int>   fds;                //coordinator end of each worker socket,
+                                    //-1 once the worker has gone away
+  vector<int>   pids;
+  int           fd{-1};             //worker end, -1 on the coordinator
+  size_t        last{0};            //worker polled first by receive
+
+  //constructors --------------------------------------------------------------
+  explicit LocalTransport(size_t workers);
+  ~LocalTransport();
+  LocalTransport(const LocalTransport &) = delete;
+  LocalTransport & operator=(const LocalTransport &) = delete;
+
+  //methods -------------------------------------------------------------------
+  bool coordinator() const override { return fd < 0; }
+  size_t workers() const override { return fds.size(); }
+  void send(size_t worker, const Message &m) override;
+  size_t receive(Message &m) override;
+  void finish() override;
+};
+
+#ifdef GW_WITH_MPI
+/*=============================================================================
+ * The #MpiTransport runs the coordinator on rank 0 of %comm and a worker on
+ * every other rank, so the same study spans nodes. Every rank returns from
+ * the study and finalizes MPI itself
+ *===========================================================================*/
+struct MpiTransport : public Transport {
+  //data ----------------------------------------------------------------------
+  MPI_Comm      comm;
+  int           rank{0}, size{1};
+  vector<char>  buf;
+
+  //constructors --------------------------------------------------------------
+  explicit MpiTransport(MPI_Comm comm = MPI_COMM_WORLD);
+
+  //methods -------------------------------------------------------------------
+  bool coordinator() const override { return rank == 0; }
+  size_t workers() const override { return size - 1; }
+  void send(size_t worker, const Message &m) override;
+  size_t receive(Message &m) override;
+};
+#endif
+
+/*=============================================================================
+ * The #StudyCoordinator shards the scenarios 0..n-1 of an embarrassingly
+ * parallel study (contingencies, time steps, samples) over the workers of a
+ * #Transport. Workers pull work, each keeps up to %depth scenarios queued so
+ * that it never waits on the coordinator, and a fast worker simply takes
+ * more of them. The results are merged on the coordinator as they arrive,
+ * or in scenario order when %ordered is set. Scenarios queued on a worker
+ * that goes away are handed to the others. An exception thrown by the work
+ * of a scenario stops the study and is rethrown on the coordinator
+ *===========================================================================*/
+struct StudyCoordinator {
+  //types ---------------------------------------------------------------------
+  //computes scenario on a worker and returns its serialized result
+  using Work = std::function<vector<char>(size_t)>;
+
+  //receives the result of a scenario on the coordinator
+  using Merge = std::function<void(size_t, const vector<char>&)>;
+
+  //data ----------------------------------------------------------------------
+  Transport         &transport;
+  size_t            depth{2};       //scenarios queued per worker
+  bool              ordered{false};
+  size_t            completed{0}, reassigned{0};
+  vector<size_t>    done;           //scenarios completed by each worker
+
+  //constructors --------------------------------------------------------------
+  explicit StudyCoordinator(Transport &transport);
+
+  //methods -------------------------------------------------------------------
+  //runs the study on every process of the transport, @work is called on the
+  //workers and @merge on the coordinator
+  void run(size_t n, const Work &work, const Merge &merge);
+
+  void coordinate(size_t n, const Merge &merge);
+  void serve(const Work &work);
+};
+
+/*=============================================================================
+ * A #MappedFile maps a file read only into memory, the pages are shared by
+ * every process on a machine that maps it, see $snapshotFromJson
+ *===========================================================================*/
+struct MappedFile {
+  //data ----------------------------------------------------------------------
+  const char    *data{nullptr};
+  size_t        size{0};
+
+  //constructors --------------------------------------------------------------
+  explicit MappedFile(const std::string &path);
+  ~MappedFile();
+  MappedFile(const MappedFile &) = delete;
+  MappedFile & operator=(const MappedFile &) = delete;
+};
+
+}
+
+#endif
@@ -0,0 +1,251 @@
+#include "SymbolicCache.hxx"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <unistd.h>
+
+using namespace gridworks;
+using std::string;
+using std::runtime_error;
+
+static const uint32_t version{2};
+
+//the contents of one cache file
+struct CacheEntry {
+  uint64_t              nbus{0};
+  JacobiStructureInfo   jsi;
+  vector<array<int,2>>  jidx;
+  vector<sindex>        r, c, perm;
+  int64_t               method{0};  //ordering option behind %perm
+};
+
+template <class T>
+static void put(std::ostream &o, T x)
+{
+  o.write(reinterpret_cast<const char*>(&x), sizeof(T));
+}
+
+template <class T>
+static T get(std::istream &in)
+{
+  T x{};
+  in.read(reinterpret_cast<char*>(&x), sizeof(T));
+  return x;
+}
+
+//indices are stored 64 bit wide so that LP64 and ILP64 builds share entries
+static void putIndices(std::ostream &o, const sindex *x, size_t n)
+{
+  for(size_t i=0; i<n; ++i) { put<int64_t>(o, x[i]); }
+}
+
+static void getIndices(std::istream &in, vector<sindex> &x, size_t n)
+{
+  x.resize(n);
+  for(size_t i=0; i<n; ++i) { x[i] = get<int64_t>(in); }
+}
+
+//reads the entry for @hash at @path, which must be laid out for the buses
+//of @g. Nothing is allocated before the sizes are checked against @g and
+//against what is left of the file
+static bool read(const string &path, uint64_t hash, const Grid &g,
+                 CacheEntry &e)
+{
+  std::ifstream in(path, std::ios::binary | std::ios::ate);
+  if(!in.good()) { return false; }
+  uint64_t size = in.tellg();
+  in.seekg(0);
+
+  char magic[4];
+  in.read(magic, 4);
+  if(!in || string(magic, 4) != "GWSC") { return false; }
+  if(get<uint32_t>(in) != version || get<uint64_t>(in) != hash) {
+    return false;
+  }
+
+  e.nbus = get<uint64_t>(in);
+  for(int &x : e.jsi.n) { x = get<int32_t>(in); }
+  for(int &x : e.jsi.s) { x = get<int32_t>(in); }
+  int64_t N = get<int64_t>(in), S = get<int64_t>(in);
+  if(!in || N != e.jsi.N() || S != e.jsi.S() || N < 0 || S < 0) {
+    return false;
+  }
+
+  int64_t rows{0};
+  for(const Bus *b : g.buses) { rows += !b->slack + b->qRow(); }
+  if(e.nbus != g.buses.size() || N != rows) { return false; }
+  uint64_t need = 8*e.nbus + 8*(uint64_t(N) + 1) + 8*uint64_t(S) + 8;
+  if(need > size - uint64_t(in.tellg())) { return false; }
+
+  e.jidx.resize(e.nbus);
+  for(array<int,2> &j : e.jidx)
+  {
+    j[0] = get<int32_t>(in);
+    j[1] = get<int32_t>(in);
+  }
+  getIndices(in, e.r, N+1);
+  getIndices(in, e.c, S);
+  uint64_t np = get<uint64_t>(in);
+  if(!in || (np != 0 && np != static_cast<uint64_t>(N))) { return false; }
+  getIndices(in, e.perm, np);
+  e.method = get<int64_t>(in);
+  return static_cast<bool>(in);
+}
+
+//checks a cache entry against the grid it is meant for
+static bool verify(const Grid &g, const CacheEntry &e)
+{
+  if(e.nbus != g.buses.size()) { return false; }
+
+  //index assignment, see Jacobi::computeStructureInfo
+  int n0{0}, n1{0};
+  for(const Bus *b : g.buses) { if(!b->slack) { ++n0; } }
+  int k0{0}, k1{n0};
+  for(size_t i=0; i<g.buses.size(); ++i)
+  {
+    const Bus &b = *g.buses[i];
+    if(!b.slack && e.jidx[i][0] != k0++) { return false; }
+    if(b.qRow())
+    {
+      if(e.jidx[i][1] != k1++) { return false; }
+      ++n1;
+    }
+  }
+  if(e.jsi.n[0] != n0 || e.jsi.n[1] != n1) { return false; }
+
+  //row lengths and sorted, in range columns
+  JacobiStructureInfo jsi = e.jsi;
+  sindex N = jsi.N(), S = jsi.S();
+  if(e.r[0] != 0 || e.r[N] != S) { return false; }
+  auto row = [&](const Bus &b, sindex i, sindex diag)
+  {
+    sindex len = 1 + b.qRow();
+    for(const Neighbor &nb : b.neighbors) {
+      len += !nb.b->slack + nb.b->qRow();
+    }
+    sindex cb = e.r[i], ce = e.r[i+1];
+    if(cb < 0 || cb > ce || ce > S || ce - cb != len) { return false; }
+    const sindex *c = e.c.data();
+    for(sindex k=cb; k<ce; ++k)
+    {
+      if(c[k] < 0 || c[k] >= N) { return false; }
+      if(k > cb && c[k] <= c[k-1]) { return false; }
+    }
+    return std::binary_search(c + cb, c + ce, diag);
+  };
+  for(size_t i=0; i<g.buses.size(); ++i)
+  {
+    const Bus &b = *g.buses[i];
+    if(!b.slack && !row(b, e.jidx[i][0], e.jidx[i][0])) { return false; }
+    if(b.qRow() && !row(b, e.jidx[i][1], e.jidx[i][1])) { return false; }
+  }
+
+  //the permutation must be one
+  if(!e.perm.empty())
+  {
+    vector<char> seen(N, 0);
+    for(sindex p : e.perm)
+    {
+      if(p < 0 || p >= N || seen[p]) { return false; }
+      seen[p] = 1;
+    }
+  }
+  return true;
+}
+
+SymbolicCache::SymbolicCache(string dir) : dir{dir} {}
+
+string SymbolicCache::path(uint64_t hash) const
+{
+  std::stringstream ss;
+  ss << dir << "/" << std::hex << std::setw(16) << std::setfill('0') << hash
+     << ".gwsym";
+  return ss.str();
+}
+
+bool SymbolicCache::load(Jacobi &J)
+{
+  CacheEntry e;
+  string p = path(J.topology);
+  if(!std::ifstream(p).good())
+  {
+    ++misses;
+    return false;
+  }
+  if(!read(p, J.topology, *J.g, e) || !verify(*J.g, e))
+  {
+    ++rejected;
+    ++misses;
+    return false;
+  }
+
+  for(size_t i=0; i<J.g->buses.size(); ++i)
+  {
+    Bus &b = *J.g->buses[i];
+    if(!b.slack) { b.jidx[0] = e.jidx[i][0]; }
+    if(b.qRow()) { b.jidx[1] = e.jidx[i][1]; }
+  }
+  J.jsi = e.jsi;
+  J.m = std::make_shared<SMatrix<double>>(J.jsi.N(), J.jsi.S());
+  std::copy(e.r.begin(), e.r.end(), J.m->r);
+  std::copy(e.c.begin(), e.c.end(), J.m->c);
+  if(!e.perm.empty()) { orders[J.topology] = {e.method, std::move(e.perm)}; }
+
+  ++hits;
+  return true;
+}
+
+vector<sindex> SymbolicCache::order(const Jacobi &J, int64_t method)
+{
+  auto o = orders.find(J.topology);
+  if(o == orders.end() || o->second.first != method) { return {}; }
+  return o->second.second;
+}
+
+void SymbolicCache::store(const Jacobi &J, const vector<sindex> &perm,
+                          int64_t method)
+{
+  const Grid &g = *J.g;
+  const SMatrix<double> &m = *J.m;
+  string p = path(J.topology),
+         tmp = p + ".tmp" + std::to_string(getpid());
+
+  {
+    std::ofstream out(tmp, std::ios::binary);
+    if(!out.good()) {
+      throw runtime_error("Unable to write file " + tmp);
+    }
+    out.write("GWSC", 4);
+    put<uint32_t>(out, version);
+    put<uint64_t>(out, J.topology);
+    put<uint64_t>(out, g.buses.size());
+    for(int x : J.jsi.n) { put<int32_t>(out, x); }
+    for(int x : J.jsi.s) { put<int32_t>(out, x); }
+    put<int64_t>(out, m.n);
+    put<int64_t>(out, m.s);
+    for(const Bus *b : g.buses)
+    {
+      put<int32_t>(out, b->jidx[0]);
+      put<int32_t>(out, b->jidx[1]);
+    }
+    putIndices(out, m.r, m.n+1);
+    putIndices(out, m.c, m.s);
+    put<uint64_t>(out, perm.size());
+    putIndices(out, perm.data(), perm.size());
+    put<int64_t>(out, method);
+    if(!out.good()) {
+      throw runtime_error("Unable to write file " + tmp);
+    }
+  }
+
+  //concurrent writers of one topology write the same entry, the last rename
+  //wins
+  if(std::rename(tmp.c_str(), p.c_str()) != 0)
+  {
+    std::remove(tmp.c_str());
+    throw runtime_error("Unable to write file " + p);
+  }
+  if(!perm.empty()) { orders[J.topology] = {method, perm}; }
+}
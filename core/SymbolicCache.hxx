@@ -0,0 +1,59 @@
+#ifndef GW_SYMBOLICCACHE
+#define GW_SYMBOLICCACHE
+
+#include "Grid.hxx"
+#include <string>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+
+namespace gridworks {
+
+/*=============================================================================
+ * The #SymbolicCache keeps the symbolic setup of the power flow on disk, one
+ * file per $topologyHash in %dir: the jacobian pattern, the jacobian indices
+ * of every bus and the fill reducing permutation of the sparse solver along
+ * with the ordering option that computed it. A new process on a topology it
+ * has seen before restores these instead of recomputing them, the
+ * permutation only when it asks for the same ordering.
+ *
+ * A cached entry is checked against the grid before it is used, the bus
+ * count, the index assignment, the row lengths and ordering of the pattern
+ * and the permutation must all be consistent or the entry is ignored and
+ * rewritten. Files are written to a temporary name and renamed into place so
+ * that concurrent jobs never read a partial entry
+ *===========================================================================*/
+struct SymbolicCache {
+  //data ----------------------------------------------------------------------
+  std::string     dir;
+  size_t          hits{0}, misses{0},
+                  rejected{0};      //entries unreadable or failing
+                                    //verification
+  std::unordered_map<uint64_t, std::pair<int64_t, vector<sindex>>> orders;
+                                    //loaded permutations and the ordering
+                                    //option that computed them
+
+  //constructors --------------------------------------------------------------
+  explicit SymbolicCache(std::string dir);
+
+  //methods -------------------------------------------------------------------
+  //restores the structure of @J for its topology, false if there is no valid
+  //entry, in which case @J is left untouched
+  bool load(Jacobi &J);
+
+  //the cached fill reducing permutation for the topology of @J, empty if
+  //there is none or it was computed by another ordering than @method
+  vector<sindex> order(const Jacobi &J, int64_t method);
+
+  //writes the structure of @J and the permutation @perm computed by the
+  //ordering @method, the permutation may be empty
+  void store(const Jacobi &J, const vector<sindex> &perm = {},
+             int64_t method = 0);
+
+  //the file of the entry for topology @hash
+  std::string path(uint64_t hash) const;
+};
+
+}
+
+#endif
@@ -0,0 +1,266 @@
+#include "Transient.hxx"
+#include <algorithm>
+#include <cmath>
+
+using namespace gridworks;
+using std::vector;
+using std::runtime_error;
+using std::to_string;
+
+Event::Event(double t, Kind kind, int bus, Branch *branch, complex zf)
+  : t{t}, kind{kind}, bus{bus}, branch{branch}, zf{zf} {}
+
+TransientSimulator::TransientSimulator(Grid *g, Glob<complex> v0,
+    Glob<complex> sLoad)
+  : G{g}, v(g->buses.size()), inj(g->buses.size())
+{
+  Y = ymatrix(*g).canonical();
+  sindex nb = g->buses.size();
+  Glob<complex> s = g->sCalc(v0, Y);
+  yfault.assign(nb, complex{0,0});
+
+  //loads and static generators as constant impedances
+  for(sindex i=0; i<nb; ++i) {
+    Y[{i,i}] += std::conj(sLoad.data[i]) / std::norm(v0.data[i]);
+  }
+  for(Generator *gen : g->generators)
+  {
+    sindex b = gen->bus_id;
+    if(gen->kind == Generator::Kind::Static)
+    {
+      complex sg = s.data[b] + sLoad.data[b];
+      Y[{b,b}] -= std::conj(sg) / std::norm(v0.data[b]);
+      continue;
+    }
+    machines.push_back(gen);
+  }
+
+  n = machines.size();
+  bus = Glob<int>(n);
+  for(Glob<double> *a : {&H, &D, &xd, &xq, &xdp, &xqp, &iTd0, &iTq0,
+                         &Pm, &Efd, &id, &iq, &pe}) {
+    *a = Glob<double>(n);
+  }
+  for(Glob<double> *a : {&x, &x0, &f0, &f1}) { *a = Glob<double>(4*n); }
+
+  for(size_t k=0; k<n; ++k)
+  {
+    const ClassicalGen &m = static_cast<const ClassicalGen&>(*machines[k]);
+    sindex b = m.bus_id;
+    bus[k] = b;
+    H[k] = m.H;
+    D[k] = m.D;
+    xdp[k] = m.xdp;
+    if(m.kind == Generator::Kind::FourthOrder)
+    {
+      const FourthOrderGen &f = static_cast<const FourthOrderGen&>(m);
+      xd[k] = f.xd;
+      xq[k] = f.xq;
+      xqp[k] = f.xqp;
+      iTd0[k] = 1.0 / f.Td0p;
+      iTq0[k] = 1.0 / f.Tq0p;
+    }
+    else
+    {
+      xd[k] = xq[k] = xqp[k] = m.xdp;
+      iTd0[k] = iTq0[k] = 0;
+    }
+    Y[{b,b}] += 1.0 / complex{0, xdp[k]};
+
+    //steady state behind the power flow solution, the q axis lies along
+    //V + j xq I
+    complex vt = v0.data[b],
+            I = std::conj((s.data[b] + sLoad.data[b]) / vt),
+            eq = vt + complex{0, xq[k]} * I;
+    double delta = std::arg(eq);
+    complex rot{std::sin(delta), std::cos(delta)},
+            vdq = vt * rot,
+            idq = I * rot;
+    id[k] = idq.real();
+    iq[k] = idq.imag();
+    pe[k] = (vt * std::conj(I)).real();
+    Pm[k] = pe[k];
+    x[k] = delta;
+    x[n+k] = 1.0;
+    x[2*n+k] = vdq.imag() + xdp[k] * id[k];
+    x[3*n+k] = vdq.real() - xqp[k] * iq[k];
+    Efd[k] = x[2*n+k] + (xd[k] - xdp[k]) * id[k];
+  }
+  std::copy(v0.data, v0.data + nb, v.data);
+
+  mkl_err = dss_create(mkl_handle, dss_opt);
+  if(mkl_err != MKL_DSS_SUCCESS) { mkl_death(); }
+
+  mkl_err = dss_define_structure(
+      mkl_handle, dss_struct_opt, Y.r, Y.n, Y.n, Y.c, Y.s);
+  if(mkl_err != MKL_DSS_SUCCESS) { mkl_death(); }
+
+  mkl_err = dss_reorder(mkl_handle, dss_reorder_opt, 0);
+  if(mkl_err != MKL_DSS_SUCCESS) { mkl_death(); }
+
+  factor();
+}
+
+TransientSimulator::~TransientSimulator()
+{
+  dss_delete(mkl_handle, dss_solve_opt);
+}
+
+void TransientSimulator::mkl_death()
+{
+  throw runtime_error{
+    "MKL has exploded with error: " + to_string(mkl_err)
+  };
+}
+
+void TransientSimulator::factor()
+{
+  mkl_err = dss_factor_complex(mkl_handle, dss_factor_opt, Y.v);
+  if(mkl_err != MKL_DSS_SUCCESS) { mkl_death(); }
+  ++factorizations;
+}
+
+void TransientSimulator::fault(double t, int bus, complex zf)
+{
+  events.push_back({t, Event::Kind::Fault, bus, nullptr, zf});
+}
+
+void TransientSimulator::clear(double t, int bus)
+{
+  events.push_back({t, Event::Kind::Clear, bus});
+}
+
+void TransientSimulator::trip(double t, Branch *br)
+{
+  events.push_back({t, Event::Kind::Trip, -1, br});
+}
+
+void TransientSimulator::apply(const Event &e)
+{
+  sindex b = e.bus;
+  switch(e.kind)
+  {
+    case Event::Kind::Fault:
+    {
+      //a bolted fault is a very large shunt conductance
+      complex y = std::abs(e.zf) > 0 ? 1.0 / e.zf : complex{1e8, 0};
+      Y[{b,b}] += y;
+      yfault[b] += y;
+      break;
+    }
+
+    case Event::Kind::Clear:
+      Y[{b,b}] -= yfault[b];
+      yfault[b] = 0;
+      break;
+
+    case Event::Kind::Trip:
+    {
+      //the entries stay in the pattern with the branch removed from their
+      //values, so the symbolic analysis still holds
+      PiModel p = piModel(*e.branch);
+      sindex i = e.branch->b[0]->id, j = e.branch->b[1]->id;
+      Y[{i,i}] -= p.y00;
+      Y[{i,j}] -= p.y01;
+      Y[{j,i}] -= p.y10;
+      Y[{j,j}] -= p.y11;
+      break;
+    }
+  }
+}
+
+void TransientSimulator::evaluate(const double *s, double *f)
+{
+  const double *dl = s, *w = s + n, *eq = s + 2*n, *ed = s + 3*n;
+  double *fd = f, *fw = f + n, *feq = f + 2*n, *fed = f + 3*n;
+  const int *b = bus.data;
+  const double *H_ = H.data, *D_ = D.data, *xd_ = xd.data, *xq_ = xq.data,
+               *xdp_ = xdp.data, *xqp_ = xqp.data,
+               *iTd0_ = iTd0.data, *iTq0_ = iTq0.data,
+               *Pm_ = Pm.data, *Efd_ = Efd.data;
+  double *id_ = id.data, *iq_ = iq.data, *pe_ = pe.data;
+  double ws = omega_s;
+  long m = n;
+
+  //Norton sources E/(j xd'), E is taken round to the network frame
+  double *ij = reinterpret_cast<double*>(inj.data);
+  std::fill(inj.data, inj.data + inj.sz, complex{0,0});
+  #pragma omp parallel for simd
+  for(long k=0; k<m; ++k)
+  {
+    double sd = std::sin(dl[k]), cd = std::cos(dl[k]),
+           Ed = ed[k] + (xqp_[k] - xdp_[k]) * iq_[k],
+           Er = Ed * sd + eq[k] * cd,
+           Ei = eq[k] * sd - Ed * cd;
+    ij[2*b[k]] = Ei / xdp_[k];
+    ij[2*b[k]+1] = -Er / xdp_[k];
+  }
+
+  _INTEGER_t nrhs{1};
+  mkl_err = dss_solve_complex(mkl_handle, dss_solve_opt, inj.data, nrhs,
+                              v.data);
+  if(mkl_err != MKL_DSS_SUCCESS) { mkl_death(); }
+
+  //stator currents in the machine frame and the swing and flux equations
+  const double *vv = reinterpret_cast<const double*>(v.data);
+  #pragma omp parallel for simd
+  for(long k=0; k<m; ++k)
+  {
+    double sd = std::sin(dl[k]), cd = std::cos(dl[k]),
+           vr = vv[2*b[k]], vi = vv[2*b[k]+1],
+           vd = vr * sd - vi * cd,
+           vq = vr * cd + vi * sd,
+           idk = (eq[k] - vq) / xdp_[k],
+           iqk = (vd - ed[k]) / xqp_[k],
+           p = vd * idk + vq * iqk;
+    id_[k] = idk;
+    iq_[k] = iqk;
+    pe_[k] = p;
+    fd[k] = ws * (w[k] - 1.0);
+    fw[k] = (Pm_[k] - p - D_[k] * (w[k] - 1.0)) / (2.0 * H_[k]);
+    feq[k] = (Efd_[k] - eq[k] - (xd_[k] - xdp_[k]) * idk) * iTd0_[k];
+    fed[k] = (-ed[k] + (xq_[k] - xqp_[k]) * iqk) * iTq0_[k];
+  }
+}
+
+void TransientSimulator::run(double tend, const Visitor &visit)
+{
+  std::stable_sort(events.begin(), events.end(),
+      [](const Event &a, const Event &b) { return a.t < b.t; });
+
+  double *xs = x.data, *xo = x0.data, *fa = f0.data, *fb = f1.data;
+  long m = 4*n;
+
+  evaluate(xs, fa);
+  while(t < tend - 0.5*h)
+  {
+    //events due within this step switch the network before it is taken
+    size_t e{0};
+    for(; e<events.size() && events[e].t <= t + 0.5*h; ++e) {
+      apply(events[e]);
+    }
+    if(e > 0)
+    {
+      events.erase(events.begin(), events.begin() + e);
+      factor();
+      evaluate(xs, fa);
+    }
+
+    //Heun, the network solve at the corrected state feeds the next step
+    double dt = h;
+    #pragma omp parallel for simd
+    for(long i=0; i<m; ++i)
+    {
+      xo[i] = xs[i];
+      xs[i] += dt * fa[i];
+    }
+    evaluate(xs, fb);
+    #pragma omp parallel for simd
+    for(long i=0; i<m; ++i) { xs[i] = xo[i] + 0.5 * dt * (fa[i] + fb[i]); }
+    evaluate(xs, fa);
+
+    t += h;
+    ++steps;
+    if(visit) { visit(t, v); }
+  }
+}
@@ -0,0 +1,124 @@
+#ifndef GW_TRANSIENT
+#define GW_TRANSIENT
+
+#include "Grid.hxx"
+#include <mkl_dss.h>
+#include <functional>
+#include <stdexcept>
+#include <string>
+
+namespace gridworks {
+
+/*=============================================================================
+ * An #Event is a switching action applied to the network during a transient
+ * simulation
+ *===========================================================================*/
+struct Event {
+  //types ---------------------------------------------------------------------
+  enum class Kind{ Fault, Clear, Trip };
+
+  //data ----------------------------------------------------------------------
+  double    t;                  //time of the event, seconds
+  Kind      kind;
+  int       bus;                //faulted or cleared bus
+  Branch    *branch;            //tripped branch
+  complex   zf;                 //fault impedance, zero for a bolted fault
+
+  //constructors --------------------------------------------------------------
+  Event(double t, Kind kind, int bus, Branch *branch = nullptr,
+        complex zf = {0,0});
+};
+
+/*=============================================================================
+ * The #TransientSimulator integrates the electromechanical dynamics of the
+ * #ClassicalGen and #FourthOrderGen machines of a grid after a disturbance.
+ *
+ * The network is the admittance matrix with every load as a constant
+ * impedance and every machine as a Norton source behind 1/(j xd'). Static
+ * generators become constant (negative) impedances at their power flow
+ * output. This matrix only changes on switching events, so it is factored
+ * once and refactored only when an event is applied, each time step costs two
+ * sparse solves. Saliency (xq' != xd') enters the Norton source through the
+ * q axis current of the previous network solution.
+ *
+ * Machine states are held as four contiguous arrays [delta|omega|eq'|ed'],
+ * the derivatives of all machines are computed in one vectorized loop and
+ * the states are advanced with Heun's method. A classical machine is a two
+ * axis machine with infinite time constants and xq = xq' = xd'
+ *===========================================================================*/
+struct TransientSimulator {
+  //types ---------------------------------------------------------------------
+  //receives the time and the bus voltages after every step
+  using Visitor = std::function<void(double, Glob<complex>)>;
+
+  //data ----------------------------------------------------------------------
+  Grid              *G;
+  SMatrix<complex>  Y{0,0};       //augmented network admittance
+  Glob<complex>     v, inj;       //bus voltages, Norton injections
+  vector<complex>   yfault;       //fault admittance applied at each bus
+  vector<Event>     events;
+
+  size_t            n{0};         //number of machines
+  vector<Generator*> machines;
+  Glob<int>         bus;
+  Glob<double>      H, D, xd, xq, xdp, xqp,
+                    iTd0, iTq0,   //inverse time constants, zero if classical
+                    Pm, Efd,
+                    id, iq, pe;   //stator currents and electrical power
+  Glob<double>      x, x0, f0, f1; //states and derivatives, 4n each
+
+  double            h{0.005},     //time step, seconds
+                    t{0},
+                    omega_s{2*M_PI*60}; //synchronous speed, rad/s
+  int               steps{0}, factorizations{0};
+
+  _MKL_DSS_HANDLE_t mkl_handle;
+  _INTEGER_t mkl_err{ MKL_DSS_SUCCESS };
+  _INTEGER_t
+    dss_opt{ MKL_DSS_MSG_LVL_WARNING +
+             MKL_DSS_TERM_LVL_ERROR +
+             MKL_DSS_ZERO_BASED_INDEXING
+           },
+    dss_struct_opt{ MKL_DSS_NON_SYMMETRIC_COMPLEX },
+    dss_reorder_opt{ MKL_DSS_AUTO_ORDER },
+    dss_factor_opt{ MKL_DSS_INDEFINITE },
+    dss_solve_opt{ MKL_DSS_DEFAULTS };
+
+  //constructors --------------------------------------------------------------
+  //initializes the machines from the solved power flow voltages @v0 and the
+  //load @sLoad consumed at every bus
+  TransientSimulator(Grid *g, Glob<complex> v0, Glob<complex> sLoad);
+  ~TransientSimulator();
+  TransientSimulator(const TransientSimulator &) = delete;
+  TransientSimulator & operator=(const TransientSimulator &) = delete;
+
+  //methods -------------------------------------------------------------------
+  //schedules a fault at @bus through @zf at time @t
+  void fault(double t, int bus, complex zf = {0,0});
+
+  //schedules removal of the fault at @bus at time @t
+  void clear(double t, int bus);
+
+  //schedules opening @br at time @t
+  void trip(double t, Branch *br);
+
+  //integrates until @tend handing every step to @visit
+  void run(double tend, const Visitor &visit = nullptr);
+
+  //state arrays of the machines
+  double* delta() { return x.data; }
+  double* omega() { return x.data + n; }
+
+  void apply(const Event &e);
+  void factor();
+
+  //solves the network for the machine states @s and computes the machine
+  //derivatives into @f
+  void evaluate(const double *s, double *f);
+
+  void mkl_death();
+};
+
+}
+
+#endif
@@ -11,6 +11,9 @@ namespace gridworks {
 
 constexpr size_t ALIGNMENT{64};
 
+//sparse index type, follows the MKL integer width chosen at build time
+using sindex = MKL_INT;
+
 template <class T>
 T* aalloc(size_t n) { return (T*)_mm_malloc(sizeof(T)*n, ALIGNMENT); }
   
@@ -32,6 +35,14 @@ struct Glob
 
   T& operator[](size_t i){ return data[i]; }
 
+  //copies share their data, clone makes a separate copy
+  Glob clone() const
+  {
+    Glob c(sz);
+    for(size_t i=0; i<sz; ++i) { c.data[i] = data[i]; }
+    return c;
+  }
+
 };
   
 constexpr double rad(double deg) { return deg * (M_PI / 180.0); }
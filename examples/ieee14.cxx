@@ -2,7 +2,7 @@
 #include "PowerFlow.hxx"
 #include <iostream>
 #include <fstream>
-#include "IP.hxx"
+#include "IPMapping.hxx"
 
 using namespace gridworks;
 using ip::Network;
@@ -177,24 +177,10 @@ void show_bus_topo()
 }
 
 void init_ip() {
-  for(const Bus *bus : grid.buses) {
-    network.hosts.push_back(new Host(bus->id));
-  }
-  for(const Line *l : grid.lines) {
-    Link *lnk = new Link(100, abs(l->z())*250);
-    Host *a = network.hosts[l->b[0]->id];
-    Host *b = network.hosts[l->b[1]->id];
-    connect(a,lnk,b);
-    network.links.push_back(lnk);
-  }
-  for(const Transformer *t : grid.transformers) {
-    Link *lnk = new Link(100, abs(t->z())*250);
-    Host *a = network.hosts[t->b[0]->id];
-    Host *b = network.hosts[t->b[1]->id];
-    connect(a,lnk,b);
-    network.links.push_back(lnk);
-  }
-
+  //a host per bus, links along lines and transformers
+  ip::MappingRules rules;
+  rules.scope = ip::MappingRules::Scope::Bus;
+  network = ip::fromGrid(grid, rules).network;
 }
 
 int main() {
@@ -206,7 +192,7 @@ int main() {
 
   //init_ip();
   //std::ofstream ofs("ieee14.topdl");
-  //ofs << network.topDL();
+  //network.topDL(ofs);
 
 
   SMatrix<complex> Y = ymatrix(grid);
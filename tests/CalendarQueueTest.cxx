@@ -0,0 +1,82 @@
+#include "NetSim.hxx"
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace gridworks::ip;
+
+//pops every event of @q, checking that they leave in time order and in push
+//order at equal times. Up to three new events are pushed at each popped one
+//plus one of @times, @pushes in all
+static bool drain(CalendarQueue &q, std::mt19937 &rng, const char *name,
+                  int pushes, const std::vector<double> &times)
+{
+  std::uniform_int_distribution<size_t> pick(0, times.size() - 1);
+  std::uniform_int_distribution<int> burst(0, 3);
+  double t{-1};
+  uint64_t seq{0};
+  size_t popped{0}, pushed{q.size};
+  while(!q.empty())
+  {
+    CalendarQueue::Entry e = q.pop();
+    ++popped;
+    if(e.t < t || (e.t == t && e.seq < seq))
+    {
+      std::printf("%s: popped t=%g seq=%llu after t=%g seq=%llu\n", name,
+                  e.t, (unsigned long long)e.seq, t, (unsigned long long)seq);
+      return false;
+    }
+    t = e.t;
+    seq = e.seq;
+    for(int k=burst(rng); k>0 && pushes>0; --k, --pushes)
+    {
+      q.push(e.t + times[pick(rng)], 0);
+      ++pushed;
+    }
+  }
+  if(popped != pushed)
+  {
+    std::printf("%s: popped %zu of %zu events\n", name, popped, pushed);
+    return false;
+  }
+  return true;
+}
+
+int main()
+{
+  std::mt19937 rng(7);
+  bool ok{true};
+
+  for(int run=0; run<200; ++run)
+  {
+    //random times
+    {
+      CalendarQueue q;
+      std::exponential_distribution<double> gap(1.0);
+      std::vector<double> times;
+      for(int i=0; i<64; ++i) { times.push_back(gap(rng)); }
+      for(int i=0; i<200; ++i) { q.push(times[i % times.size()] * 40, i); }
+      ok = drain(q, rng, "random", 2000, times) && ok;
+    }
+
+    //bursts of equal times on the multiples of a width that is not exact
+    //in binary, so many events land right at a day boundary
+    {
+      CalendarQueue q;
+      std::vector<double> times;
+      for(int i=0; i<40; ++i) { times.push_back(0.3 * i); }
+      for(int i=0; i<300; ++i) { q.push(0.3 * (i % 17), i); }
+      ok = drain(q, rng, "boundaries", 3000, times) && ok;
+    }
+
+    //one instant only, the whole queue is one burst
+    {
+      CalendarQueue q;
+      for(int i=0; i<1000; ++i) { q.push(3.0, i); }
+      ok = drain(q, rng, "burst", 1000, {0.0}) && ok;
+    }
+  }
+
+  std::printf(ok ? "calendar queue ok\n" : "calendar queue FAILED\n");
+  return ok ? 0 : 1;
+}